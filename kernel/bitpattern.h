@@ -25,27 +25,46 @@
 
 YOSYS_NAMESPACE_BEGIN
 
+// A set of bit patterns, stored as a set of cubes.  Each cube is kept as
+// packed 64-bit words: a mask of the defined bits and their values, so
+// that matching and containment checks work on 64 bits at a time.
 struct BitPatternPool
 {
 	int width;
 	struct bits_t {
-		std::vector<RTLIL::State> bitdata;
+		// mask words followed by value words
+		std::vector<uint64_t> words;
 		mutable unsigned int cached_hash;
-		bits_t(int width = 0) : bitdata(width), cached_hash(0) { }
-		RTLIL::State &operator[](int index) {
-			return bitdata[index];
+		bits_t(int width = 0) : words(2 * ((width + 63) / 64)), cached_hash(0) { }
+		int nwords() const {
+			return GetSize(words) / 2;
 		}
-		const RTLIL::State &operator[](int index) const {
-			return bitdata[index];
+		uint64_t mask(int index) const {
+			return words[index];
+		}
+		uint64_t value(int index) const {
+			return words[nwords() + index];
+		}
+		void set(int bit, RTLIL::State state) {
+			int n = nwords(), w = bit / 64;
+			uint64_t m = uint64_t(1) << (bit % 64);
+			words[w] &= ~m;
+			words[n + w] &= ~m;
+			if (state <= RTLIL::State::S1) {
+				words[w] |= m;
+				if (state == RTLIL::State::S1)
+					words[n + w] |= m;
+			}
+			cached_hash = 0;
 		}
 		bool operator==(const bits_t &other) const {
 			if (hash() != other.hash())
 				return false;
-			return bitdata == other.bitdata;
+			return words == other.words;
 		}
 		unsigned int hash() const {
 			if (!cached_hash)
-				cached_hash = hash_ops<std::vector<RTLIL::State>>::hash(bitdata);
+				cached_hash = hash_ops<std::vector<uint64_t>>::hash(words);
 			return cached_hash;
 		}
 	};
@@ -56,12 +75,9 @@ struct BitPatternPool
 		width = sig.size();
 		if (width > 0) {
 			bits_t pattern(width);
-			for (int i = 0; i < width; i++) {
-				if (sig[i].wire == NULL && sig[i].data <= RTLIL::State::S1)
-					pattern[i] = sig[i].data;
-				else
-					pattern[i] = RTLIL::State::Sa;
-			}
+			for (int i = 0; i < width; i++)
+				if (sig[i].wire == NULL)
+					pattern.set(i, sig[i].data);
 			database.insert(pattern);
 		}
 	}
@@ -69,31 +85,37 @@ struct BitPatternPool
 	BitPatternPool(int width)
 	{
 		this->width = width;
-		if (width > 0) {
-			bits_t pattern(width);
-			for (int i = 0; i < width; i++)
-				pattern[i] = RTLIL::State::Sa;
-			database.insert(pattern);
-		}
+		if (width > 0)
+			database.insert(bits_t(width));
 	}
 
 	bits_t sig2bits(RTLIL::SigSpec sig)
 	{
-		bits_t bits;
-		bits.bitdata = sig.as_const().bits;
-		for (auto &b : bits.bitdata)
-			if (b > RTLIL::State::S1)
-				b = RTLIL::State::Sa;
+		log_assert(sig.is_fully_const());
+		log_assert(GetSize(sig) == width);
+		bits_t bits(width);
+		for (int i = 0; i < width; i++)
+			bits.set(i, sig[i].data);
 		return bits;
 	}
 
-	bool match(bits_t a, bits_t b)
+	bool match(const bits_t &a, const bits_t &b)
 	{
-		log_assert(int(a.bitdata.size()) == width);
-		log_assert(int(b.bitdata.size()) == width);
-		for (int i = 0; i < width; i++)
-			if (a[i] <= RTLIL::State::S1 && b[i] <= RTLIL::State::S1 && a[i] != b[i])
+		for (int i = 0; i < a.nwords(); i++)
+			if (a.mask(i) & b.mask(i) & (a.value(i) ^ b.value(i)))
+				return false;
+		return true;
+	}
+
+	// a matches b, and all bits undefined in b are also undefined in a
+	bool contains(const bits_t &a, const bits_t &b)
+	{
+		for (int i = 0; i < a.nwords(); i++) {
+			if (a.mask(i) & ~b.mask(i))
+				return false;
+			if (a.mask(i) & (a.value(i) ^ b.value(i)))
 				return false;
+		}
 		return true;
 	}
 
@@ -110,13 +132,8 @@ struct BitPatternPool
 	{
 		bits_t bits = sig2bits(sig);
 		for (auto &it : database)
-			if (match(it, bits)) {
-				for (int i = 0; i < width; i++)
-					if (bits[i] > RTLIL::State::S1 && it[i] <= RTLIL::State::S1)
-						goto next_database_entry;
+			if (contains(it, bits))
 				return true;
-	next_database_entry:;
-			}
 		return false;
 	}
 
@@ -124,21 +141,30 @@ struct BitPatternPool
 	{
 		bool status = false;
 		bits_t bits = sig2bits(sig);
+		std::vector<bits_t> new_patterns;
 		for (auto it = database.begin(); it != database.end();)
 			if (match(*it, bits)) {
-				for (int i = 0; i < width; i++) {
-					if ((*it)[i] != RTLIL::State::Sa || bits[i] == RTLIL::State::Sa)
-						continue;
-					bits_t new_pattern;
-					new_pattern.bitdata = it->bitdata;
-					new_pattern[i] = bits[i] == RTLIL::State::S1 ? RTLIL::State::S0 : RTLIL::State::S1;
-					database.insert(new_pattern);
+				// for every bit undefined in the pattern but defined in sig,
+				// keep the pattern with that bit set to the opposite value
+				int n = it->nwords();
+				for (int w = 0; w < n; w++) {
+					uint64_t todo = bits.mask(w) & ~it->mask(w);
+					for (int b = 0; b < 64 && (todo >> b); b++) {
+						if (!(todo >> b & 1))
+							continue;
+						bits_t new_pattern;
+						new_pattern.words = it->words;
+						new_pattern.words[w] |= uint64_t(1) << b;
+						new_pattern.words[n + w] |= ~bits.value(w) & (uint64_t(1) << b);
+						new_patterns.push_back(std::move(new_pattern));
+					}
 				}
 				it = database.erase(it);
 				status = true;
-				continue;
 			} else
 				++it;
+		for (auto &pattern : new_patterns)
+			database.insert(pattern);
 		return status;
 	}
 
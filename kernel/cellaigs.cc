@@ -18,6 +18,7 @@
  */
 
 #include "kernel/cellaigs.h"
+#include "libs/ezsat/ezsat.h"
 
 YOSYS_NAMESPACE_BEGIN
 
@@ -512,4 +513,275 @@ optimize:;
 	new_nodes.swap(nodes);
 }
 
+ModuleAig::ModuleAig(SigMap *sigmap) : sigmap(sigmap)
+{
+	nodes.push_back(Node{-1, -1});
+}
+
+bool ModuleAig::add_cell(Cell *cell)
+{
+	if (cells.count(cell))
+		return true;
+
+	Aig aig(cell);
+	if (aig.name.empty())
+		return false;
+
+	auto it = aig_index.find(aig.name);
+	if (it == aig_index.end()) {
+		it = aig_index.emplace(aig.name, GetSize(aigs)).first;
+		aigs.push_back(std::move(aig));
+	}
+
+	CellInfo &info = cells[cell];
+	info.aig = it->second;
+	for (auto &node : aigs[info.aig].nodes)
+		for (auto &op : node.outports)
+			info.outputs.push_back((*sigmap)(cell->getPort(op.first)[op.second]));
+
+	for (auto bit : info.outputs)
+		if (bit.wire != nullptr) {
+			invalidate(bit);
+			drivers[bit] = cell;
+		}
+	return true;
+}
+
+void ModuleAig::remove_cell(Cell *cell)
+{
+	auto it = cells.find(cell);
+	if (it == cells.end())
+		return;
+
+	for (auto &node : aigs[it->second.aig].nodes)
+		if (node.portbit >= 0) {
+			auto r = readers.find((*sigmap)(cell->getPort(node.portname)[node.portbit]));
+			if (r != readers.end())
+				r->second.erase(cell);
+		}
+
+	vector<SigBit> outputs = std::move(it->second.outputs);
+	cells.erase(it);
+
+	for (auto bit : outputs) {
+		if (bit.wire == nullptr)
+			continue;
+		invalidate(bit);
+		auto drv = drivers.find(bit);
+		if (drv != drivers.end() && drv->second == cell)
+			drivers.erase(drv);
+	}
+}
+
+void ModuleAig::invalidate(SigBit bit)
+{
+	vector<SigBit> worklist = {bit};
+	while (!worklist.empty())
+	{
+		SigBit b = worklist.back();
+		worklist.pop_back();
+
+		if (!bit_lits.erase(b))
+			continue;
+
+		auto it = readers.find(b);
+		if (it == readers.end())
+			continue;
+
+		for (auto cell : it->second) {
+			CellInfo &info = cells.at(cell);
+			if (!info.built)
+				continue;
+			info.built = false;
+			info.output_lits.clear();
+			for (auto out : info.outputs)
+				if (out.wire != nullptr)
+					worklist.push_back(out);
+		}
+		readers.erase(it);
+	}
+}
+
+int ModuleAig::make_and(int a, int b)
+{
+	if (a > b)
+		std::swap(a, b);
+	if (a == 0)
+		return 0;
+	if (a == 1 || a == b)
+		return b;
+	if ((a ^ 1) == b)
+		return 0;
+
+	auto it = strash.find(pair<int, int>(a, b));
+	if (it != strash.end())
+		return it->second;
+
+	int lit = 2*GetSize(nodes);
+	nodes.push_back(Node{a, b});
+	strash.emplace(pair<int, int>(a, b), lit);
+	return lit;
+}
+
+int ModuleAig::input_lit(SigBit bit)
+{
+	auto it = input_nodes.find(bit);
+	if (it != input_nodes.end())
+		return it->second;
+
+	int lit = 2*GetSize(nodes);
+	nodes.push_back(Node{-1, GetSize(inputs)});
+	inputs.push_back(bit);
+	input_nodes.emplace(bit, lit);
+	return lit;
+}
+
+int ModuleAig::bit_lit(SigBit bit)
+{
+	bit = (*sigmap)(bit);
+	if (bit.wire == nullptr)
+		return bit == State::S1 ? 1 : 0;
+
+	auto it = bit_lits.find(bit);
+	if (it != bit_lits.end())
+		return it->second;
+
+	auto drv = drivers.find(bit);
+	if (drv == drivers.end())
+		return bit_lits[bit] = input_lit(bit);
+
+	build(drv->second);
+	return bit_lits.at(bit);
+}
+
+const vector<int> &ModuleAig::cell_output_lits(Cell *cell)
+{
+	build(cell);
+	return cells.at(cell).output_lits;
+}
+
+void ModuleAig::build(Cell *cell)
+{
+	if (cells.at(cell).built)
+		return;
+
+	// Depth first without recursion, deep cones would overflow the stack.
+	// A driver that is still on the stack closes a combinational loop, its
+	// output is read as an input then.
+	vector<Cell*> stack = {cell};
+	pool<Cell*> on_stack = {cell};
+
+	while (!stack.empty())
+	{
+		Cell *top = stack.back();
+		Cell *next = nullptr;
+
+		for (auto &node : aigs[cells.at(top).aig].nodes)
+		{
+			if (node.portbit < 0)
+				continue;
+
+			SigBit bit = (*sigmap)(top->getPort(node.portname)[node.portbit]);
+			if (bit.wire == nullptr || bit_lits.count(bit))
+				continue;
+
+			auto drv = drivers.find(bit);
+			if (drv == drivers.end() || cells.at(drv->second).built)
+				continue;
+
+			if (on_stack.count(drv->second)) {
+				bit_lits[bit] = input_lit(bit);
+				continue;
+			}
+
+			next = drv->second;
+			break;
+		}
+
+		if (next != nullptr) {
+			stack.push_back(next);
+			on_stack.insert(next);
+			continue;
+		}
+
+		import_cell(top);
+		stack.pop_back();
+		on_stack.erase(top);
+	}
+}
+
+void ModuleAig::import_cell(Cell *cell)
+{
+	CellInfo &info = cells.at(cell);
+	const Aig &aig = aigs[info.aig];
+
+	vector<int> lits(GetSize(aig.nodes));
+	info.output_lits.clear();
+
+	for (int i = 0; i < GetSize(aig.nodes); i++)
+	{
+		const AigNode &node = aig.nodes[i];
+		int lit = 0;
+
+		if (node.portbit >= 0) {
+			SigBit bit = (*sigmap)(cell->getPort(node.portname)[node.portbit]);
+			lit = bit_lit(bit);
+			if (bit.wire != nullptr)
+				readers[bit].insert(cell);
+		} else if (node.left_parent >= 0)
+			lit = make_and(lits[node.left_parent], lits[node.right_parent]);
+
+		if (node.inverter)
+			lit ^= 1;
+		lits[i] = lit;
+
+		for (int j = 0; j < GetSize(node.outports); j++)
+			info.output_lits.push_back(lit);
+	}
+
+	info.built = true;
+	for (int i = 0; i < GetSize(info.outputs); i++)
+		if (info.outputs[i].wire != nullptr && !bit_lits.count(info.outputs[i]))
+			bit_lits[info.outputs[i]] = info.output_lits[i];
+}
+
+int ModuleAig::export_lit(ezSAT *ez, vector<int> &node_literals, int lit, const std::function<int(SigBit)> &import_input) const
+{
+	// ezSAT never uses 0 as a literal, it marks nodes not yet encoded.
+	if (GetSize(node_literals) < GetSize(nodes))
+		node_literals.resize(GetSize(nodes), 0);
+
+	vector<int> stack = {lit >> 1};
+	while (!stack.empty())
+	{
+		int n = stack.back();
+		if (node_literals[n] != 0) {
+			stack.pop_back();
+			continue;
+		}
+
+		const Node &node = nodes[n];
+		if (n == 0) {
+			node_literals[n] = ez->CONST_FALSE;
+		} else if (node.left < 0) {
+			node_literals[n] = import_input(inputs[node.right]);
+		} else {
+			int l = node_literals[node.left >> 1];
+			int r = node_literals[node.right >> 1];
+			if (l == 0 || r == 0) {
+				if (l == 0)
+					stack.push_back(node.left >> 1);
+				if (r == 0)
+					stack.push_back(node.right >> 1);
+				continue;
+			}
+			node_literals[n] = ez->AND((node.left & 1) ? ez->NOT(l) : l, (node.right & 1) ? ez->NOT(r) : r);
+		}
+		stack.pop_back();
+	}
+
+	int result = node_literals[lit >> 1];
+	return (lit & 1) ? ez->NOT(result) : result;
+}
+
 YOSYS_NAMESPACE_END
@@ -21,6 +21,9 @@
 #define CELLAIGS_H
 
 #include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+
+class ezSAT;
 
 YOSYS_NAMESPACE_BEGIN
 
@@ -47,6 +50,73 @@ struct Aig
 	unsigned int hash() const;
 };
 
+// A structurally hashed AIG for a set of combinational cells of a module,
+// built from the per-cell AIGs above. Logic that is shared between cells is
+// represented only once. Bits that are not driven by a cell in the set are
+// inputs of the AIG.
+//
+// Literals are 2*node+inverted, node 0 is the constant false. Nodes are only
+// ever added, so literals stay valid when cells are added or removed. The
+// graph for a cell is built on first use. remove_cell() must be called while
+// the cell is still connected.
+struct ModuleAig
+{
+	struct Node {
+		// Fanin literals of an AND node, for input nodes `left` is -1 and
+		// `right` the index into `inputs`.
+		int left, right;
+	};
+
+	SigMap *sigmap;
+	vector<Node> nodes;
+	vector<SigBit> inputs;
+
+	ModuleAig(SigMap *sigmap);
+
+	// Returns false if there is no AIG for the cell type.
+	bool add_cell(Cell *cell);
+	void remove_cell(Cell *cell);
+	bool has_cell(Cell *cell) const { return cells.count(cell) != 0; }
+
+	// The literal of the value of a bit.
+	int bit_lit(SigBit bit);
+
+	// The output bits of a cell and the literals for the values the cell
+	// drives on them. For bits on a combinational loop these differ from
+	// bit_lit(), which breaks the loop with an input.
+	const vector<SigBit> &cell_outputs(Cell *cell) const { return cells.at(cell).outputs; }
+	const vector<int> &cell_output_lits(Cell *cell);
+
+	int make_and(int a, int b);
+	int input_lit(SigBit bit);
+
+	// Encodes a literal in a SAT solver. `node_literals` caches the solver
+	// literals of nodes that are already encoded in the same context,
+	// `import_input` is used for input nodes.
+	int export_lit(ezSAT *ez, vector<int> &node_literals, int lit, const std::function<int(SigBit)> &import_input) const;
+
+private:
+	struct CellInfo {
+		int aig;
+		bool built = false;
+		vector<SigBit> outputs;
+		vector<int> output_lits;
+	};
+
+	vector<Aig> aigs;
+	dict<string, int> aig_index;
+	dict<Cell*, CellInfo> cells;
+	dict<SigBit, Cell*> drivers;
+	dict<SigBit, int> bit_lits;
+	dict<SigBit, pool<Cell*>> readers;
+	dict<pair<int, int>, int> strash;
+	dict<SigBit, int> input_nodes;
+
+	void build(Cell *cell);
+	void import_cell(Cell *cell);
+	void invalidate(SigBit bit);
+};
+
 YOSYS_NAMESPACE_END
 
 #endif
@@ -569,131 +569,245 @@ void FfData::unmap_srst() {
 	has_srst = false;
 }
 
-Cell *FfData::emit() {
-	remove();
-	if (!width)
-		return nullptr;
-	if (!has_aload && !has_clk && !has_gclk && !has_sr) {
-		if (has_arst) {
-			// Convert this case to a D latch.
-			arst_to_aload();
+namespace {
+	char pol_char(bool pol) {
+		return pol ? 'P' : 'N';
+	}
+
+	char val_char(const Const &val) {
+		return val.as_bool() ? '1' : '0';
+	}
+
+	// Sets the given ports and parameters on a cell, and removes all
+	// others.  Unchanged ports are left alone.
+	struct CellSetter {
+		Cell *cell;
+		IdString ports[8], params[8];
+		int nports = 0, nparams = 0;
+
+		CellSetter(Cell *cell, IdString type) : cell(cell) {
+			cell->type = type;
+		}
+
+		void port(IdString name, const SigSpec &sig) {
+			cell->setPort(name, sig);
+			ports[nports++] = name;
+		}
+
+		void param(IdString name, const Const &val) {
+			Const &old = cell->parameters[name];
+			if (old != val)
+				old = val;
+			params[nparams++] = name;
+		}
+
+		void finish() {
+			std::vector<IdString> extra;
+			for (auto &conn : cell->connections())
+				if (std::find(ports, ports + nports, conn.first) == ports + nports)
+					extra.push_back(conn.first);
+			for (auto name : extra)
+				cell->unsetPort(name);
+			extra.clear();
+			for (auto &param : cell->parameters)
+				if (std::find(params, params + nparams, param.first) == params + nparams)
+					extra.push_back(param.first);
+			for (auto name : extra)
+				cell->parameters.erase(name);
+		}
+	};
+}
+
+IdString FfData::cell_type() const {
+	if (has_gclk) {
+		log_assert(!has_clk);
+		log_assert(!has_ce);
+		log_assert(!has_aload);
+		log_assert(!has_arst);
+		log_assert(!has_srst);
+		log_assert(!has_sr);
+		if (is_fine)
+			log_assert(!is_anyinit);
+		if (is_anyinit)
+			log_assert(val_init.is_fully_undef());
+	} else if (!has_aload && !has_clk) {
+		log_assert(has_sr);
+	} else if (!has_clk) {
+		log_assert(!has_srst);
+	}
+
+	if (!is_fine) {
+		if (has_gclk)
+			return is_anyinit ? ID($anyinit) : ID($ff);
+		else if (!has_aload && !has_clk)
+			return ID($sr);
+		else if (!has_clk)
+			return has_sr ? ID($dlatchsr) : has_arst ? ID($adlatch) : ID($dlatch);
+		else if (has_sr)
+			return has_ce ? ID($dffsre) : ID($dffsr);
+		else if (has_arst)
+			return has_ce ? ID($adffe) : ID($adff);
+		else if (has_aload)
+			return has_ce ? ID($aldffe) : ID($aldff);
+		else if (has_srst)
+			return !has_ce ? ID($sdff) : ce_over_srst ? ID($sdffce) : ID($sdffe);
+		else
+			return has_ce ? ID($dffe) : ID($dff);
+	} else {
+		if (has_gclk)
+			return ID($_FF_);
+		else if (!has_aload && !has_clk)
+			return stringf("$_SR_%c%c_", pol_char(pol_set), pol_char(pol_clr));
+		else if (!has_clk) {
+			if (has_sr)
+				return stringf("$_DLATCHSR_%c%c%c_", pol_char(pol_aload), pol_char(pol_set), pol_char(pol_clr));
+			else if (has_arst)
+				return stringf("$_DLATCH_%c%c%c_", pol_char(pol_aload), pol_char(pol_arst), val_char(val_arst));
+			else
+				return stringf("$_DLATCH_%c_", pol_char(pol_aload));
+		} else if (has_sr) {
+			if (has_ce)
+				return stringf("$_DFFSRE_%c%c%c%c_", pol_char(pol_clk), pol_char(pol_set), pol_char(pol_clr), pol_char(pol_ce));
+			else
+				return stringf("$_DFFSR_%c%c%c_", pol_char(pol_clk), pol_char(pol_set), pol_char(pol_clr));
+		} else if (has_arst) {
+			if (has_ce)
+				return stringf("$_DFFE_%c%c%c%c_", pol_char(pol_clk), pol_char(pol_arst), val_char(val_arst), pol_char(pol_ce));
+			else
+				return stringf("$_DFF_%c%c%c_", pol_char(pol_clk), pol_char(pol_arst), val_char(val_arst));
+		} else if (has_aload) {
+			if (has_ce)
+				return stringf("$_ALDFFE_%c%c%c_", pol_char(pol_clk), pol_char(pol_aload), pol_char(pol_ce));
+			else
+				return stringf("$_ALDFF_%c%c_", pol_char(pol_clk), pol_char(pol_aload));
+		} else if (has_srst) {
+			if (has_ce)
+				return stringf(ce_over_srst ? "$_SDFFCE_%c%c%c%c_" : "$_SDFFE_%c%c%c%c_", pol_char(pol_clk), pol_char(pol_srst), val_char(val_srst), pol_char(pol_ce));
+			else
+				return stringf("$_SDFF_%c%c%c_", pol_char(pol_clk), pol_char(pol_srst), val_char(val_srst));
 		} else {
-			// No control inputs left.  Turn into a const driver.
-			module->connect(sig_q, val_init);
-			return nullptr;
+			if (has_ce)
+				return stringf("$_DFFE_%c%c_", pol_char(pol_clk), pol_char(pol_ce));
+			else
+				return stringf("$_DFF_%c_", pol_char(pol_clk));
 		}
 	}
-	if (initvals && !is_anyinit)
-		initvals->set_init(sig_q, val_init);
+}
+
+void FfData::update_cell() {
+	CellSetter c(cell, cell_type());
+	c.port(ID::Q, sig_q);
 	if (!is_fine) {
+		c.param(ID::WIDTH, GetSize(sig_q));
 		if (has_gclk) {
-			log_assert(!has_clk);
-			log_assert(!has_ce);
-			log_assert(!has_aload);
-			log_assert(!has_arst);
-			log_assert(!has_srst);
-			log_assert(!has_sr);
-			if (is_anyinit) {
-				cell = module->addAnyinit(name, sig_d, sig_q);
-				log_assert(val_init.is_fully_undef());
-			} else {
-				cell = module->addFf(name, sig_d, sig_q);
-			}
+			c.port(ID::D, sig_d);
 		} else if (!has_aload && !has_clk) {
-			log_assert(has_sr);
-			cell = module->addSr(name, sig_set, sig_clr, sig_q, pol_set, pol_clr);
+			c.port(ID::SET, sig_set);
+			c.port(ID::CLR, sig_clr);
+			c.param(ID::SET_POLARITY, pol_set);
+			c.param(ID::CLR_POLARITY, pol_clr);
 		} else if (!has_clk) {
-			log_assert(!has_srst);
-			if (has_sr)
-				cell = module->addDlatchsr(name, sig_aload, sig_set, sig_clr, sig_ad, sig_q, pol_aload, pol_set, pol_clr);
-			else if (has_arst)
-				cell = module->addAdlatch(name, sig_aload, sig_arst, sig_ad, sig_q, val_arst, pol_aload, pol_arst);
-			else
-				cell = module->addDlatch(name, sig_aload, sig_ad, sig_q, pol_aload);
+			c.port(ID::EN, sig_aload);
+			c.port(ID::D, sig_ad);
+			c.param(ID::EN_POLARITY, pol_aload);
+			if (has_sr) {
+				c.port(ID::SET, sig_set);
+				c.port(ID::CLR, sig_clr);
+				c.param(ID::SET_POLARITY, pol_set);
+				c.param(ID::CLR_POLARITY, pol_clr);
+			} else if (has_arst) {
+				c.port(ID::ARST, sig_arst);
+				c.param(ID::ARST_POLARITY, pol_arst);
+				c.param(ID::ARST_VALUE, val_arst);
+			}
 		} else {
+			c.port(ID::CLK, sig_clk);
+			c.port(ID::D, sig_d);
+			c.param(ID::CLK_POLARITY, pol_clk);
+			if (has_ce) {
+				c.port(ID::EN, sig_ce);
+				c.param(ID::EN_POLARITY, pol_ce);
+			}
 			if (has_sr) {
-				if (has_ce)
-					cell = module->addDffsre(name, sig_clk, sig_ce, sig_set, sig_clr, sig_d, sig_q, pol_clk, pol_ce, pol_set, pol_clr);
-				else
-					cell = module->addDffsr(name, sig_clk, sig_set, sig_clr, sig_d, sig_q, pol_clk, pol_set, pol_clr);
+				c.port(ID::SET, sig_set);
+				c.port(ID::CLR, sig_clr);
+				c.param(ID::SET_POLARITY, pol_set);
+				c.param(ID::CLR_POLARITY, pol_clr);
 			} else if (has_arst) {
-				if (has_ce)
-					cell = module->addAdffe(name, sig_clk, sig_ce, sig_arst, sig_d, sig_q, val_arst, pol_clk, pol_ce, pol_arst);
-				else
-					cell = module->addAdff(name, sig_clk, sig_arst, sig_d, sig_q, val_arst, pol_clk, pol_arst);
+				c.port(ID::ARST, sig_arst);
+				c.param(ID::ARST_POLARITY, pol_arst);
+				c.param(ID::ARST_VALUE, val_arst);
 			} else if (has_aload) {
-				if (has_ce)
-					cell = module->addAldffe(name, sig_clk, sig_ce, sig_aload, sig_d, sig_q, sig_ad, pol_clk, pol_ce, pol_aload);
-				else
-					cell = module->addAldff(name, sig_clk, sig_aload, sig_d, sig_q, sig_ad, pol_clk, pol_aload);
+				c.port(ID::ALOAD, sig_aload);
+				c.port(ID::AD, sig_ad);
+				c.param(ID::ALOAD_POLARITY, pol_aload);
 			} else if (has_srst) {
-				if (has_ce)
-					if (ce_over_srst)
-						cell = module->addSdffce(name, sig_clk, sig_ce, sig_srst, sig_d, sig_q, val_srst, pol_clk, pol_ce, pol_srst);
-					else
-						cell = module->addSdffe(name, sig_clk, sig_ce, sig_srst, sig_d, sig_q, val_srst, pol_clk, pol_ce, pol_srst);
-				else
-					cell = module->addSdff(name, sig_clk, sig_srst, sig_d, sig_q, val_srst, pol_clk, pol_srst);
-			} else {
-				if (has_ce)
-					cell = module->addDffe(name, sig_clk, sig_ce, sig_d, sig_q, pol_clk, pol_ce);
-				else
-					cell = module->addDff(name, sig_clk, sig_d, sig_q, pol_clk);
+				c.port(ID::SRST, sig_srst);
+				c.param(ID::SRST_POLARITY, pol_srst);
+				c.param(ID::SRST_VALUE, val_srst);
 			}
 		}
 	} else {
 		if (has_gclk) {
-			log_assert(!has_clk);
-			log_assert(!has_ce);
-			log_assert(!has_aload);
-			log_assert(!has_arst);
-			log_assert(!has_srst);
-			log_assert(!has_sr);
-			log_assert(!is_anyinit);
-			cell = module->addFfGate(name, sig_d, sig_q);
+			c.port(ID::D, sig_d);
 		} else if (!has_aload && !has_clk) {
-			log_assert(has_sr);
-			cell = module->addSrGate(name, sig_set, sig_clr, sig_q, pol_set, pol_clr);
+			c.port(ID::S, sig_set);
+			c.port(ID::R, sig_clr);
 		} else if (!has_clk) {
-			log_assert(!has_srst);
-			if (has_sr)
-				cell = module->addDlatchsrGate(name, sig_aload, sig_set, sig_clr, sig_ad, sig_q, pol_aload, pol_set, pol_clr);
-			else if (has_arst)
-				cell = module->addAdlatchGate(name, sig_aload, sig_arst, sig_ad, sig_q, val_arst.as_bool(), pol_aload, pol_arst);
-			else
-				cell = module->addDlatchGate(name, sig_aload, sig_ad, sig_q, pol_aload);
+			c.port(ID::E, sig_aload);
+			c.port(ID::D, sig_ad);
+			if (has_sr) {
+				c.port(ID::S, sig_set);
+				c.port(ID::R, sig_clr);
+			} else if (has_arst) {
+				c.port(ID::R, sig_arst);
+			}
 		} else {
+			c.port(ID::C, sig_clk);
+			c.port(ID::D, sig_d);
+			if (has_ce)
+				c.port(ID::E, sig_ce);
 			if (has_sr) {
-				if (has_ce)
-					cell = module->addDffsreGate(name, sig_clk, sig_ce, sig_set, sig_clr, sig_d, sig_q, pol_clk, pol_ce, pol_set, pol_clr);
-				else
-					cell = module->addDffsrGate(name, sig_clk, sig_set, sig_clr, sig_d, sig_q, pol_clk, pol_set, pol_clr);
+				c.port(ID::S, sig_set);
+				c.port(ID::R, sig_clr);
 			} else if (has_arst) {
-				if (has_ce)
-					cell = module->addAdffeGate(name, sig_clk, sig_ce, sig_arst, sig_d, sig_q, val_arst.as_bool(), pol_clk, pol_ce, pol_arst);
-				else
-					cell = module->addAdffGate(name, sig_clk, sig_arst, sig_d, sig_q, val_arst.as_bool(), pol_clk, pol_arst);
+				c.port(ID::R, sig_arst);
 			} else if (has_aload) {
-				if (has_ce)
-					cell = module->addAldffeGate(name, sig_clk, sig_ce, sig_aload, sig_d, sig_q, sig_ad, pol_clk, pol_ce, pol_aload);
-				else
-					cell = module->addAldffGate(name, sig_clk, sig_aload, sig_d, sig_q, sig_ad, pol_clk, pol_aload);
+				c.port(ID::L, sig_aload);
+				c.port(ID::AD, sig_ad);
 			} else if (has_srst) {
-				if (has_ce)
-					if (ce_over_srst)
-						cell = module->addSdffceGate(name, sig_clk, sig_ce, sig_srst, sig_d, sig_q, val_srst.as_bool(), pol_clk, pol_ce, pol_srst);
-					else
-						cell = module->addSdffeGate(name, sig_clk, sig_ce, sig_srst, sig_d, sig_q, val_srst.as_bool(), pol_clk, pol_ce, pol_srst);
-				else
-					cell = module->addSdffGate(name, sig_clk, sig_srst, sig_d, sig_q, val_srst.as_bool(), pol_clk, pol_srst);
-			} else {
-				if (has_ce)
-					cell = module->addDffeGate(name, sig_clk, sig_ce, sig_d, sig_q, pol_clk, pol_ce);
-				else
-					cell = module->addDffGate(name, sig_clk, sig_d, sig_q, pol_clk);
+				c.port(ID::R, sig_srst);
 			}
 		}
 	}
+	c.finish();
+}
+
+Cell *FfData::emit() {
+	if (!width || (!has_aload && !has_clk && !has_gclk && !has_sr && !has_arst)) {
+		remove();
+		// No control inputs left.  Turn into a const driver.
+		if (width)
+			module->connect(sig_q, val_init);
+		return nullptr;
+	}
+	if (!has_aload && !has_clk && !has_gclk && !has_sr) {
+		// Convert this case to a D latch.
+		arst_to_aload();
+	}
+	// Reuse the existing cell if it still has the right name.  This keeps
+	// unchanged connections in place instead of tearing down and
+	// recreating the cell.
+	bool in_place = cell != nullptr && cell->name == name && cell->module == module;
+	if (in_place)
+		remove_init();
+	else
+		remove();
+	if (initvals && !is_anyinit)
+		initvals->set_init(sig_q, val_init);
+	if (!in_place)
+		cell = module->addCell(name, cell_type());
+	update_cell();
 	cell->attributes = attributes;
 	return cell;
 }
@@ -200,8 +200,18 @@ struct FfData {
 		unmap_srst();
 	}
 
+	// Creates the FF cell, or updates the existing cell in place if it
+	// still has the same name.  May return nullptr if the FF degenerates
+	// to a constant driver.
 	Cell *emit();
 
+	// The cell type emit() uses for this FF.
+	IdString cell_type() const;
+
+	// Sets the type, ports and parameters of `cell` to this FF and removes
+	// all others.  Used by emit() for both new and reused cells.
+	void update_cell();
+
 	// Removes init attribute from the Q output, but keeps val_init unchanged.
 	// It will be automatically reattached on emit.  Use this before changing sig_q.
 	void remove_init() {
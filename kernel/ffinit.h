@@ -74,13 +74,20 @@ struct FfInitVals
 
 	RTLIL::Const operator()(const RTLIL::SigSpec &sig) const
 	{
+		if (initbits.empty())
+			return RTLIL::Const(State::Sx, GetSize(sig));
 		RTLIL::Const res;
-		for (auto bit : sig)
-			res.bits.push_back((*this)(bit));
+		res.bits.reserve(GetSize(sig));
+		for (auto bit : (*sigmap)(sig)) {
+			auto it = initbits.find(bit);
+			res.bits.push_back(it != initbits.end() ? it->second.first : State::Sx);
+		}
 		return res;
 	}
 
-	void set_init(RTLIL::SigBit bit, RTLIL::State val)
+	// Updates the init value of a single bit, returns the wire whose
+	// init attribute may have become fully undefined (or nullptr).
+	RTLIL::Wire *set_init_bit(RTLIL::SigBit bit, RTLIL::State val)
 	{
 		SigBit mbit = (*sigmap)(bit);
 		SigBit abit = bit;
@@ -88,26 +95,51 @@ struct FfInitVals
 		if (it != initbits.end())
 			abit = it->second.second;
 		else if (val == State::Sx)
-			return;
+			return nullptr;
 		log_assert(abit.wire);
 		initbits[mbit] = std::make_pair(val,abit);
 		auto it2 = abit.wire->attributes.find(ID::init);
 		if (it2 != abit.wire->attributes.end()) {
 			it2->second[abit.offset] = val;
-			if (it2->second.is_fully_undef())
-				abit.wire->attributes.erase(it2);
+			return val == State::Sx ? abit.wire : nullptr;
 		} else if (val != State::Sx) {
 			Const cval(State::Sx, GetSize(abit.wire));
 			cval[abit.offset] = val;
 			abit.wire->attributes[ID::init] = cval;
 		}
+		return nullptr;
 	}
 
+	static void cleanup_init(RTLIL::Wire *wire)
+	{
+		auto it = wire->attributes.find(ID::init);
+		if (it != wire->attributes.end() && it->second.is_fully_undef())
+			wire->attributes.erase(it);
+	}
+
+	void set_init(RTLIL::SigBit bit, RTLIL::State val)
+	{
+		RTLIL::Wire *wire = set_init_bit(bit, val);
+		if (wire)
+			cleanup_init(wire);
+	}
+
+	// Word-level variant: the init attribute of each touched wire is only
+	// checked for becoming fully undefined once, not once per bit.
 	void set_init(const RTLIL::SigSpec &sig, RTLIL::Const val)
 	{
 		log_assert(GetSize(sig) == GetSize(val));
-		for (int i = 0; i < GetSize(sig); i++)
-			set_init(sig[i], val[i]);
+		RTLIL::Wire *last_wire = nullptr;
+		pool<RTLIL::Wire*> wires;
+		for (int i = 0; i < GetSize(sig); i++) {
+			RTLIL::Wire *wire = set_init_bit(sig[i], val[i]);
+			if (wire && wire != last_wire) {
+				wires.insert(wire);
+				last_wire = wire;
+			}
+		}
+		for (auto wire : wires)
+			cleanup_init(wire);
 	}
 
 	void remove_init(RTLIL::SigBit bit)
@@ -117,8 +149,9 @@ struct FfInitVals
 
 	void remove_init(const RTLIL::SigSpec &sig)
 	{
-		for (auto bit : sig)
-			remove_init(bit);
+		if (initbits.empty())
+			return;
+		set_init(sig, RTLIL::Const(State::Sx, GetSize(sig)));
 	}
 
 	void clear()
@@ -34,6 +34,10 @@ bool FfMergeHelper::find_output_ff(RTLIL::SigSpec sig, FfData &ff, pool<std::pai
 
 	bool found = false;
 
+	// All bits of a wide register usually come from the same cell, only
+	// parse each cell once.
+	dict<Cell*, FfData> cell_ffs;
+
 	for (auto bit : sig)
 	{
 		if (bit.wire == NULL || sigbit_users_count[bit] == 0) {
@@ -60,7 +64,10 @@ bool FfMergeHelper::find_output_ff(RTLIL::SigSpec sig, FfData &ff, pool<std::pai
 		std::tie(cell, idx) = *sinks.begin();
 		bits.insert(std::make_pair(cell, idx));
 
-		FfData cur_ff(initvals, cell);
+		auto ff_it = cell_ffs.find(cell);
+		if (ff_it == cell_ffs.end())
+			ff_it = cell_ffs.emplace(cell, FfData(initvals, cell)).first;
+		const FfData &cur_ff = ff_it->second;
 
 		// Reject latches and $ff.
 		if (!cur_ff.has_clk)
@@ -164,6 +171,10 @@ bool FfMergeHelper::find_input_ff(RTLIL::SigSpec sig, FfData &ff, pool<std::pair
 
 	pool<int> const_bits;
 
+	// All bits of a wide register usually come from the same cell, only
+	// parse each cell once.
+	dict<Cell*, FfData> cell_ffs;
+
 	for (auto bit : sig)
 	{
 		if (bit.wire == NULL) {
@@ -188,7 +199,10 @@ bool FfMergeHelper::find_input_ff(RTLIL::SigSpec sig, FfData &ff, pool<std::pair
 		std::tie(cell, idx) = dff_driver[bit];
 		bits.insert(std::make_pair(cell, idx));
 
-		FfData cur_ff(initvals, cell);
+		auto ff_it = cell_ffs.find(cell);
+		if (ff_it == cell_ffs.end())
+			ff_it = cell_ffs.emplace(cell, FfData(initvals, cell)).first;
+		const FfData &cur_ff = ff_it->second;
 
 		log_assert((*sigmap)(cur_ff.sig_q[idx]) == bit);
 
@@ -295,13 +309,22 @@ bool FfMergeHelper::find_input_ff(RTLIL::SigSpec sig, FfData &ff, pool<std::pair
 
 
 void FfMergeHelper::remove_output_ff(const pool<std::pair<Cell *, int>> &bits) {
-	for (auto &it : bits) {
+	// Rewrite the Q port of each cell once, instead of once per bit.
+	dict<Cell*, std::vector<int>> cell_bits;
+	for (auto &it : bits)
+		cell_bits[it.first].push_back(it.second);
+	for (auto &it : cell_bits) {
 		Cell *cell = it.first;
-		int idx = it.second;
 		SigSpec q = cell->getPort(ID::Q);
-		initvals->remove_init(q[idx]);
-		dff_driver.erase((*sigmap)(q[idx]));
-		q[idx] = module->addWire(stringf("$ffmerge_disconnected$%d", autoidx++));
+		SigSpec old_q;
+		for (int idx : it.second)
+			old_q.append(q[idx]);
+		initvals->remove_init(old_q);
+		for (auto bit : (*sigmap)(old_q))
+			dff_driver.erase(bit);
+		Wire *disconnected = module->addWire(stringf("$ffmerge_disconnected$%d", autoidx++), GetSize(it.second));
+		for (int i = 0; i < GetSize(it.second); i++)
+			q[it.second[i]] = SigBit(disconnected, i);
 		cell->setPort(ID::Q, q);
 	}
 }
@@ -311,7 +334,7 @@ void FfMergeHelper::mark_input_ff(const pool<std::pair<Cell *, int>> &bits) {
 		Cell *cell = it.first;
 		int idx = it.second;
 		if (cell->hasPort(ID::D)) {
-			SigSpec d = cell->getPort(ID::D);
+			const SigSpec &d = cell->getPort(ID::D);
 			// The user count was already at least 1
 			// (for the D port).  Bump it as it is now connected
 			// to the merged-to cell as well.  This suffices for
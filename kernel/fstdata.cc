@@ -195,22 +195,14 @@ static void reconstruct_clb_attimes(void *user_data, uint64_t pnt_time, fstHandl
 	ptr->reconstruct_callback_attimes(pnt_time, pnt_facidx, pnt_value, plen);
 }
 
-void FstData::reconstruct_callback_attimes(uint64_t pnt_time, fstHandle pnt_facidx, const unsigned char *pnt_value, uint32_t /* plen */)
+void FstData::reconstruct_callback_attimes(uint64_t pnt_time, fstHandle pnt_facidx, const unsigned char *pnt_value, uint32_t plen)
 {
 	if (pnt_time > end_time || !pnt_value) return;
 	// if we are past the timestamp
-	bool is_clock = false;
-	if (!all_samples) {
-		for(auto &s : clk_signals) {
-			if (s==pnt_facidx)  { 
-				is_clock=true;
-				break;
-			}
-		}
-	}
+	bool clock_change = !all_samples && is_clock[pnt_facidx];
 
 	if (pnt_time > past_time) {
-		past_data = last_data;
+		update_past_data();
 		past_time = pnt_time;
 	}
 
@@ -219,9 +211,9 @@ void FstData::reconstruct_callback_attimes(uint64_t pnt_time, fstHandle pnt_faci
 			callback(last_time);
 			last_time = pnt_time;
 		} else {
-			if (is_clock) {
-				std::string val = std::string((const char *)pnt_value);
-				std::string prev = past_data[pnt_facidx];
+			if (clock_change) {
+				std::string val = std::string((const char *)pnt_value, plen);
+				const std::string &prev = past_data[pnt_facidx];
 				if ((prev!="1" && val=="1") || (prev!="0" && val=="0")) {
 					callback(last_time);
 					last_time = pnt_time;
@@ -230,35 +222,122 @@ void FstData::reconstruct_callback_attimes(uint64_t pnt_time, fstHandle pnt_faci
 		}
 	}
 	// always update last_data
-	last_data[pnt_facidx] =  std::string((const char *)pnt_value);
+	last_data[pnt_facidx].assign((const char *)pnt_value, plen);
+	if (!is_changed[pnt_facidx]) {
+		is_changed[pnt_facidx] = true;
+		last_changed.push_back(pnt_facidx);
+	}
+}
+
+void FstData::update_past_data()
+{
+	for (auto handle : last_changed) {
+		past_data[handle] = last_data[handle];
+		past_valid[handle] = true;
+		is_changed[handle] = false;
+	}
+	last_changed.clear();
+}
+
+static void stream_clb_varlen_attimes(void *user_data, uint64_t pnt_time, fstHandle pnt_facidx, const unsigned char *pnt_value, uint32_t plen)
+{
+	FstData *ptr = (FstData*)user_data;
+	ptr->stream_callback_attimes(pnt_time, pnt_facidx, pnt_value, plen);
+}
+
+static void stream_clb_attimes(void *user_data, uint64_t pnt_time, fstHandle pnt_facidx, const unsigned char *pnt_value)
+{
+	FstData *ptr = (FstData*)user_data;
+	uint32_t plen = (pnt_value) ?  strlen((const char *)pnt_value) : 0;
+	ptr->stream_callback_attimes(pnt_time, pnt_facidx, pnt_value, plen);
+}
+
+// Runs on the decoder thread, collects value changes into batches
+void FstData::stream_callback_attimes(uint64_t pnt_time, fstHandle pnt_facidx, const unsigned char *pnt_value, uint32_t plen)
+{
+	if (pnt_time > end_time || !pnt_value) return;
+
+	ChangeBatch &batch = *stream_batch;
+	batch.changes.push_back({pnt_time, pnt_facidx, uint32_t(batch.values.size()), plen});
+	batch.values.append((const char *)pnt_value, plen);
+
+	if (batch.changes.size() >= 16384) {
+		// fails once the consumer gave up, then we only drain the file
+		stream_queue->push_back(std::move(batch));
+		batch = ChangeBatch();
+	}
+}
+
+// Decompresses the FST blocks on a separate thread, while value changes are
+// replayed through the callback on the calling thread.
+void FstData::reconstructStreaming()
+{
+	ConcurrentQueue<ChangeBatch> queue(16);
+	stream_queue = &queue;
+
+	ThreadPool decoder(1, [&](int) {
+		ChangeBatch batch;
+		stream_batch = &batch;
+		fstReaderIterBlocks2(ctx, stream_clb_attimes, stream_clb_varlen_attimes, this, nullptr);
+		if (!batch.changes.empty())
+			queue.push_back(std::move(batch));
+		queue.close();
+	});
+
+	try {
+		while (auto batch = queue.pop_front())
+			for (auto &change : batch->changes)
+				reconstruct_callback_attimes(change.time, change.handle, (const unsigned char *)batch->values.data() + change.offset, change.len);
+	} catch (...) {
+		queue.close();
+		decoder.join();
+		stream_queue = nullptr;
+		stream_batch = nullptr;
+		throw;
+	}
+
+	decoder.join();
+	stream_queue = nullptr;
+	stream_batch = nullptr;
 }
 
 void FstData::reconstructAllAtTimes(std::vector<fstHandle> &signal, uint64_t start, uint64_t end, CallbackFunction cb)
 {
-	clk_signals = signal;
+	size_t num_handles = fstReaderGetMaxHandle(ctx) + 1;
+	is_clock.assign(num_handles, false);
+	for (auto handle : signal)
+		is_clock.at(handle) = true;
 	callback = cb;
 	start_time = start;
 	end_time = end;
-	last_data.clear();
+	last_data.assign(num_handles, std::string());
 	last_time = start_time;
-	past_data.clear();
+	past_data.assign(num_handles, std::string());
+	past_valid.assign(num_handles, false);
 	past_time = start_time;
-	all_samples = clk_signals.empty();
+	is_changed.assign(num_handles, false);
+	last_changed.clear();
+	all_samples = signal.empty();
 
-	fstReaderSetUnlimitedTimeRange(ctx);
+	// Blocks after the end time are not needed, but earlier blocks carry
+	// the values at the start time.
+	fstReaderSetLimitTimeRange(ctx, 0, end_time);
 	fstReaderSetFacProcessMaskAll(ctx);
-	fstReaderIterBlocks2(ctx, reconstruct_clb_attimes, reconstruct_clb_varlen_attimes, this, nullptr);
+	if (ThreadPool::pool_size(1, 1) > 0)
+		reconstructStreaming();
+	else
+		fstReaderIterBlocks2(ctx, reconstruct_clb_attimes, reconstruct_clb_varlen_attimes, this, nullptr);
 	if (last_time!=end_time) {
-		past_data = last_data;
+		update_past_data();
 		callback(last_time);
 	}
-	past_data = last_data;
+	update_past_data();
 	callback(end_time);
 }
 
 std::string FstData::valueOf(fstHandle signal)
 {
-	if (past_data.find(signal) == past_data.end())
+	if (signal >= past_valid.size() || !past_valid[signal])
 		log_error("Signal id %d not found\n", (int)signal);
 	return past_data[signal];
 }
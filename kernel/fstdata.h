@@ -21,6 +21,7 @@
 #define FSTDATA_H
 
 #include "kernel/yosys.h"
+#include "kernel/threading.h"
 #include "libs/fst/fstapi.h"
 
 YOSYS_NAMESPACE_BEGIN
@@ -50,6 +51,7 @@ class FstData
 	std::vector<FstVar>& getVars() { return vars; };
 
 	void reconstruct_callback_attimes(uint64_t pnt_time, fstHandle pnt_facidx, const unsigned char *pnt_value, uint32_t plen);
+	void stream_callback_attimes(uint64_t pnt_time, fstHandle pnt_facidx, const unsigned char *pnt_value, uint32_t plen);
 	void reconstructAllAtTimes(std::vector<fstHandle> &signal, uint64_t start_time, uint64_t end_time, CallbackFunction cb);
 
 	std::string valueOf(fstHandle signal);
@@ -59,22 +61,44 @@ class FstData
 	const char *getTimescaleString() { return timescale_str.c_str(); }
 private:
 	void extractVarNames();
+	void update_past_data();
+	void reconstructStreaming();
+
+	// A batch of value changes in file order, decoded by the streaming
+	// thread. Values are stored back to back in `values`.
+	struct ChangeBatch
+	{
+		struct Change {
+			uint64_t time;
+			fstHandle handle;
+			uint32_t offset, len;
+		};
+		std::vector<Change> changes;
+		std::string values;
+	};
+	ChangeBatch *stream_batch = nullptr;
+	ConcurrentQueue<ChangeBatch> *stream_queue = nullptr;
 
 	struct fstReaderContext *ctx;
 	std::vector<FstVar> vars;
 	std::map<fstHandle, FstVar> handle_to_var;
 	std::map<std::string, fstHandle> name_to_handle;
 	std::map<std::string, dict<int, fstHandle>> memory_to_handle;
-	std::map<fstHandle, std::string> last_data;
+	// Values indexed by handle. past_data lags behind last_data by the
+	// handles listed in last_changed.
+	std::vector<std::string> last_data;
+	std::vector<std::string> past_data;
+	std::vector<bool> past_valid;
+	std::vector<bool> is_changed;
+	std::vector<fstHandle> last_changed;
 	uint64_t last_time;
-	std::map<fstHandle, std::string> past_data;
 	uint64_t past_time;
 	double timescale;
 	std::string timescale_str;
 	uint64_t start_time;
 	uint64_t end_time;
 	CallbackFunction callback;
-	std::vector<fstHandle> clk_signals;
+	std::vector<bool> is_clock;
 	bool all_samples;
 	std::string tmp_file;
 };
@@ -22,6 +22,27 @@
 
 USING_YOSYS_NAMESPACE
 
+namespace {
+
+	// Checks whether sig is the constant val, without materializing the
+	// constant of sig.
+	bool sig_is_const(const SigSpec &sig, const Const &val) {
+		if (GetSize(sig) != GetSize(val))
+			return false;
+		int pos = 0;
+		for (auto &chunk : sig.chunks()) {
+			if (chunk.wire != nullptr)
+				return false;
+			for (int i = 0; i < chunk.width; i++)
+				if (chunk.data[i] != val.bits[pos + i])
+					return false;
+			pos += chunk.width;
+		}
+		return true;
+	}
+
+}
+
 void Mem::remove() {
 	if (cell) {
 		module->remove(cell);
@@ -260,7 +281,11 @@ void Mem::emit() {
 				init.cell = nullptr;
 			}
 		}
-		cell->parameters[ID::INIT] = get_init_data();
+		// Rewriting the INIT parameter is expensive for large initialized
+		// memories, and most passes do not touch the init data at all.
+		auto init_it = cell->parameters.find(ID::INIT);
+		if (init_it == cell->parameters.end() || !init_data_matches(init_it->second))
+			cell->parameters[ID::INIT] = get_init_data();
 	} else {
 		if (cell) {
 			module->remove(cell);
@@ -335,7 +360,8 @@ void Mem::emit() {
 			init.cell->parameters[ID::WORDS] = GetSize(init.data) / width;
 			init.cell->parameters[ID::PRIORITY] = idx++;
 			init.cell->setPort(ID::ADDR, init.addr);
-			init.cell->setPort(ID::DATA, init.data);
+			if (!init.cell->hasPort(ID::DATA) || !sig_is_const(init.cell->getPort(ID::DATA), init.data))
+				init.cell->setPort(ID::DATA, init.data);
 			if (v2)
 				init.cell->setPort(ID::EN, init.en);
 			else
@@ -452,6 +478,41 @@ Const Mem::get_init_data() const {
 	return init_data;
 }
 
+bool Mem::init_data_matches(const Const &init_data) const {
+	if (GetSize(init_data) != width * size)
+		return false;
+	// Only handle the common case of non-overlapping inits without
+	// enable masks (as created when loading a $mem_v2 cell), anything
+	// else is reported as a mismatch.
+	std::vector<std::pair<int, const MemInit*>> chunks;
+	for (auto &init : inits) {
+		if (init.removed)
+			continue;
+		if (!init.en.is_fully_ones())
+			return false;
+		chunks.push_back({(init.addr.as_int() - start_offset) * width, &init});
+	}
+	std::sort(chunks.begin(), chunks.end(), [](const std::pair<int, const MemInit*> &a, const std::pair<int, const MemInit*> &b) { return a.first < b.first; });
+	int pos = 0;
+	for (auto &it : chunks) {
+		int offset = it.first;
+		const Const &data = it.second->data;
+		if (offset < pos)
+			return false;
+		for (; pos < offset && pos < GetSize(init_data); pos++)
+			if (init_data.bits[pos] != State::S0)
+				return false;
+		for (int i = 0; i < GetSize(data) && offset + i < GetSize(init_data); i++)
+			if (init_data.bits[offset + i] != data.bits[i])
+				return false;
+		pos = offset + GetSize(data);
+	}
+	for (; pos < GetSize(init_data); pos++)
+		if (init_data.bits[pos] != State::S0)
+			return false;
+	return true;
+}
+
 void Mem::check() {
 	int max_wide_log2 = 0;
 	for (auto &port : rd_ports) {
@@ -638,8 +699,8 @@ namespace {
 				MemInit init;
 				init.cell = cell;
 				init.attributes = cell->attributes;
-				auto addr = cell->getPort(ID::ADDR);
-				auto data = cell->getPort(ID::DATA);
+				const SigSpec &addr = cell->getPort(ID::ADDR);
+				const SigSpec &data = cell->getPort(ID::DATA);
 				if (!addr.is_fully_const())
 					log_error("Non-constant address %s in memory initialization %s.\n", log_signal(addr), log_id(cell));
 				if (!data.is_fully_const())
@@ -654,11 +715,11 @@ namespace {
 				} else {
 					init.en = RTLIL::Const(State::S1, mem->width);
 				}
-				inits.push_back(std::make_pair(cell->parameters.at(ID::PRIORITY).as_int(), init));
+				inits.push_back(std::make_pair(cell->parameters.at(ID::PRIORITY).as_int(), std::move(init)));
 			}
 			std::sort(inits.begin(), inits.end(), [](const std::pair<int, MemInit> &a, const std::pair<int, MemInit> &b) { return a.first < b.first; });
 			for (auto &it : inits)
-				res.inits.push_back(it.second);
+				res.inits.push_back(std::move(it.second));
 		}
 		for (int i = 0; i < GetSize(res.rd_ports); i++) {
 			auto &port = res.rd_ports[i];
@@ -704,25 +765,30 @@ namespace {
 		res.packed = true;
 		res.cell = cell;
 		res.attributes = cell->attributes;
-		Const &init = cell->parameters.at(ID::INIT);
+		const Const &init = cell->parameters.at(ID::INIT);
 		if (!init.is_fully_undef()) {
+			// Scan the bits in place, this runs for every memory in
+			// every memory pass and INIT may be very large.
+			auto word_undef = [&](int pos) {
+				for (int i = pos * res.width; i < (pos + 1) * res.width && i < GetSize(init); i++)
+					if (init.bits[i] != State::Sx)
+						return false;
+				return true;
+			};
 			int pos = 0;
 			while (pos < res.size) {
-				Const word = init.extract(pos * res.width, res.width, State::Sx);
-				if (word.is_fully_undef()) {
+				if (word_undef(pos)) {
 					pos++;
 				} else {
 					int epos;
-					for (epos = pos; epos < res.size; epos++) {
-						Const eword = init.extract(epos * res.width, res.width, State::Sx);
-						if (eword.is_fully_undef())
+					for (epos = pos; epos < res.size; epos++)
+						if (word_undef(epos))
 							break;
-					}
 					MemInit minit;
 					minit.addr = res.start_offset + pos;
 					minit.data = init.extract(pos * res.width, (epos - pos) * res.width, State::Sx);
 					minit.en = RTLIL::Const(State::S1, res.width);
-					res.inits.push_back(minit);
+					res.inits.push_back(std::move(minit));
 					pos = epos;
 				}
 			}
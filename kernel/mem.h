@@ -129,6 +129,11 @@ struct Mem : RTLIL::AttrObject {
 	// the whole memory.  For all non-initialized bits, Sx will be returned.
 	Const get_init_data() const;
 
+	// Checks whether init_data equals get_init_data(), without building
+	// it.  May return false negatives for complex (overlapping or masked)
+	// inits.
+	bool init_data_matches(const Const &init_data) const;
+
 	// Constructs and returns the helper structures for all memories
 	// in a module.
 	static std::vector<Mem> get_all_memories(Module *module);
@@ -20,6 +20,79 @@
 #include "kernel/qcsat.h"
 
 USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+// A cell of the input cone an UNSAT result was proven with, with a
+// fingerprint of its type, parameters and connections as seen through the
+// SigMap at that time.
+struct ConeCell {
+	IdString name;
+	uint64_t fingerprint;
+};
+
+struct ProvenFact {
+	std::vector<ConeCell> cells;
+	std::vector<IdString> onehot_wires;
+};
+
+typedef std::vector<std::tuple<SigSpec, SigSpec, bool>> FactKey;
+
+// Indexed by the hash index of the module, which is never reused. Facts of
+// deleted modules are never looked up again. The size is bounded by the
+// total number of cone cells stored, the whole cache is dropped when it
+// grows too large.
+dict<unsigned int, dict<FactKey, ProvenFact>> proven_facts;
+int proven_facts_cells = 0;
+const int max_proven_facts_cells = 1000000;
+
+// Two independent hash chains, so that a changed cell is practically never
+// mistaken for the old one.
+uint64_t cell_fingerprint(ModWalker &modwalker, Cell *cell)
+{
+	unsigned int h1 = mkhash_init, h2 = 0x9e3779b9;
+	auto add = [&](unsigned int v) {
+		h1 = mkhash(h1, v);
+		h2 = mkhash_xorshift(h2 ^ v) + v;
+	};
+	add(cell->type.hash());
+	for (auto &it : cell->parameters) {
+		add(it.first.hash());
+		add(it.second.hash());
+	}
+	for (auto &conn : cell->connections()) {
+		add(conn.first.hash());
+		add(GetSize(conn.second));
+		for (auto bit : modwalker.sigmap(conn.second))
+			add(bit.hash());
+	}
+	return (uint64_t(h1) << 32) | h2;
+}
+
+void forget_fact(const ProvenFact &fact)
+{
+	proven_facts_cells -= GetSize(fact.cells) + GetSize(fact.onehot_wires) + 1;
+}
+
+// A fact still holds if every cell of its cone is unchanged.  If signals
+// that were the same at that time are still the same now (their SigMap
+// representatives are unchanged), and every cell still imposes the same
+// constraint, the result can only have gotten more constrained.
+bool fact_still_valid(ModWalker &modwalker, const ProvenFact &fact)
+{
+	for (auto &cc : fact.cells) {
+		Cell *cell = modwalker.module->cell(cc.name);
+		if (cell == nullptr || cell_fingerprint(modwalker, cell) != cc.fingerprint)
+			return false;
+	}
+	for (auto name : fact.onehot_wires) {
+		Wire *wire = modwalker.module->wire(name);
+		if (wire == nullptr || !wire->get_bool_attribute(ID::onehot))
+			return false;
+	}
+	return true;
+}
+
+PRIVATE_NAMESPACE_END
 
 std::vector<int> QuickConeSat::importSig(SigSpec sig)
 {
@@ -98,6 +171,101 @@ void QuickConeSat::prepare()
 	}
 }
 
+bool QuickConeSat::can_be_true(const std::vector<Term> &terms)
+{
+	FactKey key;
+	for (auto &term : terms) {
+		SigSpec a = modwalker.sigmap(term.a);
+		SigSpec b = modwalker.sigmap(term.b);
+		if (GetSize(b) != 0) {
+			int width = std::max(GetSize(a), GetSize(b));
+			a.extend_u0(width);
+			b.extend_u0(width);
+		}
+		key.emplace_back(a, b, term.invert);
+	}
+	std::sort(key.begin(), key.end());
+
+	auto &module_facts = proven_facts[modwalker.module->hashidx_];
+	auto it = module_facts.find(key);
+	if (it != module_facts.end()) {
+		if (fact_still_valid(modwalker, it->second))
+			return false;
+		forget_fact(it->second);
+		module_facts.erase(it);
+	}
+
+	std::vector<int> lits;
+	for (auto &k : key) {
+		const SigSpec &a = std::get<0>(k);
+		const SigSpec &b = std::get<1>(k);
+		int lit;
+		if (GetSize(b) != 0)
+			lit = ez->vec_eq(importSig(a), importSig(b));
+		else
+			lit = ez->expression(ezSAT::OpOr, importSig(a));
+		lits.push_back(std::get<2>(k) ? ez->NOT(lit) : lit);
+	}
+	prepare();
+	if (ez->solve(ez->expression(ezSAT::OpAnd, lits)))
+		return true;
+
+	// Remember the result with the imported cells its input cone consists
+	// of.  Cells in the cone of a onehot wire bit matter for all its bits.
+	// Every onehot assumption in the solver (also those imported by earlier
+	// queries) may have contributed, so their cones are recorded as well.
+	ProvenFact fact;
+	pool<Cell*> cone;
+	pool<SigBit> seen;
+	std::vector<SigBit> queue;
+	for (auto &k : key) {
+		for (auto bit : std::get<0>(k))
+			queue.push_back(bit);
+		for (auto bit : std::get<1>(k))
+			queue.push_back(bit);
+	}
+	for (auto wire : imported_onehot) {
+		fact.onehot_wires.push_back(wire->name);
+		for (auto bit : modwalker.sigmap(wire))
+			queue.push_back(bit);
+	}
+	while (!queue.empty()) {
+		SigBit bit = queue.back();
+		queue.pop_back();
+		if (bit.wire == nullptr || !seen.insert(bit).second)
+			continue;
+		if (imported_onehot.count(bit.wire) && std::find(fact.onehot_wires.begin(), fact.onehot_wires.end(), bit.wire->name) == fact.onehot_wires.end()) {
+			fact.onehot_wires.push_back(bit.wire->name);
+			for (auto wbit : modwalker.sigmap(bit.wire))
+				queue.push_back(wbit);
+		}
+		auto drivers = modwalker.signal_drivers.find(bit);
+		if (drivers == modwalker.signal_drivers.end())
+			continue;
+		for (auto &pbit : drivers->second) {
+			if (!imported_cells.count(pbit.cell) || !cone.insert(pbit.cell).second)
+				continue;
+			fact.cells.push_back(ConeCell{pbit.cell->name, cell_fingerprint(modwalker, pbit.cell)});
+			for (auto ibit : modwalker.cell_inputs[pbit.cell])
+				queue.push_back(ibit);
+		}
+	}
+
+	// Counting the fact itself keeps facts with empty cones bounded as well.
+	int fact_cells = GetSize(fact.cells) + GetSize(fact.onehot_wires) + 1;
+	if (proven_facts_cells + fact_cells > max_proven_facts_cells) {
+		proven_facts.clear();
+		proven_facts_cells = 0;
+	}
+	auto &facts = proven_facts[modwalker.module->hashidx_];
+	auto old_fact = facts.find(key);
+	if (old_fact != facts.end())
+		forget_fact(old_fact->second);
+	facts[key] = std::move(fact);
+	proven_facts_cells += fact_cells;
+	return false;
+}
+
 int QuickConeSat::cell_complexity(RTLIL::Cell *cell)
 {
 	if (cell->type.in(ID($concat), ID($slice), ID($pos), ID($_BUF_)))
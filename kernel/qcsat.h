@@ -58,6 +58,24 @@ struct QuickConeSat {
 
 	QuickConeSat(ModWalker &modwalker) : modwalker(modwalker), ez(), satgen(ez.get(), &modwalker.sigmap) {}
 
+	// A condition for can_be_true(): any bit of `a` is set or, if `b` is
+	// not empty, `a` equals `b`.  `invert` negates the condition.
+	struct Term {
+		SigSpec a, b;
+		bool invert;
+	};
+
+	static Term any_of(SigSpec sig, bool invert = false) { return Term{sig, SigSpec(), invert}; }
+	static Term equal(SigSpec a, SigSpec b) { return Term{a, b, false}; }
+
+	// Checks whether all terms can be true at the same time, importing
+	// their input cones as needed.  As usual, only a false result is
+	// binding.  False results are remembered per module together with the
+	// cells of the input cone they were proven with, and reused by later
+	// QuickConeSat instances for the module (also in other passes) as long
+	// as these cells are unchanged.
+	bool can_be_true(const std::vector<Term> &terms);
+
 	// Imports a signal into the SAT solver, queues its input cone to be
 	// imported in the next prepare() call.
 	std::vector<int> importSig(SigSpec sig);
@@ -19,6 +19,9 @@
 
 #include "kernel/yosys.h"
 #include "kernel/satgen.h"
+#ifdef YOSYS_ENABLE_IPASIR
+#  include "libs/ezsat/ezipasir.h"
+#endif
 
 #include <string.h>
 #include <stdlib.h>
@@ -991,6 +994,51 @@ struct MinisatSatSolver : public SatSolver {
 	}
 } MinisatSatSolver;
 
+#ifdef YOSYS_ENABLE_IPASIR
+struct IpasirSatSolver : public SatSolver {
+	IpasirSatSolver() : SatSolver("ipasir") { }
+	ezSAT *create() override {
+		return new ezIpasirSAT();
+	}
+} IpasirSatSolver;
+#endif
+
+struct SatSolverPass : public Pass {
+	SatSolverPass() : Pass("satsolver", "select the SAT solver backend") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    satsolver [<name>]\n");
+		log("\n");
+		log("Select the SAT solver used by all SAT based commands (sat, freduce,\n");
+		log("equiv_simple, equiv_induct, share, opt_dff -sat, ...) for the rest of the\n");
+		log("session. Without argument the available solvers are listed.\n");
+		log("\n");
+		log("The 'minisat' solver is always available. The 'ipasir' solver is available\n");
+		log("when Yosys was built with ENABLE_IPASIR and uses the linked IPASIR solver\n");
+		log("library (e.g. CaDiCaL).\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design*) override
+	{
+		if (args.size() > 2)
+			cmd_error(args, 2, "Unexpected argument.");
+
+		if (args.size() == 2) {
+			SatSolver *solver = yosys_satsolver_list;
+			while (solver != nullptr && solver->name != args[1])
+				solver = solver->next;
+			if (solver == nullptr)
+				cmd_error(args, 1, "Unknown SAT solver.");
+			yosys_satsolver = solver;
+		}
+
+		for (auto solver = yosys_satsolver_list; solver != nullptr; solver = solver->next)
+			log("%s %s\n", solver == yosys_satsolver ? "*" : " ", solver->name.c_str());
+	}
+} SatSolverPass;
+
 struct LicensePass : public Pass {
 	LicensePass() : Pass("license", "print license terms") { }
 	void help() override
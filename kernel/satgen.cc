@@ -18,12 +18,26 @@
  */
 
 #include "kernel/satgen.h"
+#include "kernel/cellaigs.h"
 #include "kernel/ff.h"
 
 USING_YOSYS_NAMESPACE
 
 bool SatGen::importCell(RTLIL::Cell *cell, int timestep)
 {
+	if (aig != nullptr && !model_undef && aig->has_cell(cell))
+	{
+		std::string pf = prefix + (timestep == -1 ? "" : stringf("@%d:", timestep));
+		std::vector<int> &node_literals = aig_node_literals[pf];
+		auto import_input = [&](RTLIL::SigBit bit) { return importSigBit(bit, timestep); };
+
+		const std::vector<RTLIL::SigBit> &outputs = aig->cell_outputs(cell);
+		const std::vector<int> &output_lits = aig->cell_output_lits(cell);
+		for (int i = 0; i < GetSize(outputs); i++)
+			ez->assume(ez->IFF(importSigBit(outputs[i], timestep), aig->export_lit(ez, node_literals, output_lits[i], import_input)));
+		return true;
+	}
+
 	bool arith_undef_handled = false;
 	bool is_arith_compare = cell->type.in(ID($lt), ID($le), ID($ge), ID($gt));
 
@@ -57,6 +57,8 @@ struct SatSolver
 	}
 };
 
+struct ModuleAig;
+
 struct ezSatPtr : public std::unique_ptr<ezSAT> {
 	ezSatPtr() : unique_ptr<ezSAT>(yosys_satsolver->create()) { }
 };
@@ -75,6 +77,11 @@ struct SatGen
 	bool model_undef;
 	bool def_formal = false;
 
+	// When set, cells in this AIG are imported from it instead of being
+	// encoded one by one (only without undef modeling).
+	ModuleAig *aig = nullptr;
+	std::map<std::string, std::vector<int>> aig_node_literals;
+
 	SatGen(ezSAT *ez, SigMap *sigmap, std::string prefix = std::string()) :
 			ez(ez), sigmap(sigmap), prefix(prefix), ignore_div_by_zero(false), model_undef(false)
 	{
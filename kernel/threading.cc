@@ -0,0 +1,75 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/threading.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+int ThreadPool::pool_size(int reserved_cores, int work_items)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	int cores = std::thread::hardware_concurrency();
+
+	const char *env = getenv("YOSYS_MAX_THREADS");
+	if (env != nullptr && *env != 0)
+		cores = std::min(cores, atoi(env));
+
+	return std::max(std::min(cores - reserved_cores, work_items), 0);
+#else
+	(void)reserved_cores;
+	(void)work_items;
+	return 0;
+#endif
+}
+
+ThreadPool::ThreadPool(int num_threads, std::function<void(int)> body)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	for (int i = 0; i < num_threads; i++)
+		threads.emplace_back(body, i);
+#else
+	(void)body;
+	log_assert(num_threads == 0);
+#endif
+}
+
+ThreadPool::~ThreadPool()
+{
+	join();
+}
+
+int ThreadPool::num_threads() const
+{
+#ifdef YOSYS_ENABLE_THREADS
+	return GetSize(threads);
+#else
+	return 0;
+#endif
+}
+
+void ThreadPool::join()
+{
+#ifdef YOSYS_ENABLE_THREADS
+	for (auto &thread : threads)
+		thread.join();
+	threads.clear();
+#endif
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,148 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef THREADING_H
+#define THREADING_H
+
+#include "kernel/yosys.h"
+
+#include <deque>
+#include <optional>
+
+#ifdef YOSYS_ENABLE_THREADS
+#  include <condition_variable>
+#  include <mutex>
+#  include <thread>
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+// Without thread support Mutex and MutexLock do nothing.
+#ifdef YOSYS_ENABLE_THREADS
+using Mutex = std::mutex;
+using MutexLock = std::unique_lock<std::mutex>;
+#else
+struct Mutex {
+	void lock() { }
+	void unlock() { }
+};
+struct MutexLock {
+	MutexLock(Mutex &) { }
+	void lock() { }
+	void unlock() { }
+};
+#endif
+
+// A FIFO for handing items from producer threads to consumer threads.
+//
+// push_back() blocks while the queue holds `capacity` items, pop_front()
+// blocks while it is empty. After close(), push_back() discards its item and
+// returns false, and pop_front() returns the remaining items followed by
+// std::nullopt.
+//
+// Without thread support the queue never blocks, so it can only be used
+// from a single thread.
+template<typename T>
+class ConcurrentQueue
+{
+public:
+	ConcurrentQueue(size_t capacity = SIZE_MAX) : capacity(capacity) { }
+
+	bool push_back(T item)
+	{
+#ifdef YOSYS_ENABLE_THREADS
+		std::unique_lock<std::mutex> lock(mutex);
+		not_full.wait(lock, [&] { return closed || items.size() < capacity; });
+#endif
+		if (closed)
+			return false;
+		items.push_back(std::move(item));
+#ifdef YOSYS_ENABLE_THREADS
+		not_empty.notify_one();
+#endif
+		return true;
+	}
+
+	std::optional<T> pop_front()
+	{
+#ifdef YOSYS_ENABLE_THREADS
+		std::unique_lock<std::mutex> lock(mutex);
+		not_empty.wait(lock, [&] { return closed || !items.empty(); });
+#endif
+		if (items.empty())
+			return std::nullopt;
+		std::optional<T> item(std::move(items.front()));
+		items.pop_front();
+#ifdef YOSYS_ENABLE_THREADS
+		not_full.notify_one();
+#endif
+		return item;
+	}
+
+	void close()
+	{
+#ifdef YOSYS_ENABLE_THREADS
+		std::unique_lock<std::mutex> lock(mutex);
+#endif
+		closed = true;
+#ifdef YOSYS_ENABLE_THREADS
+		not_empty.notify_all();
+		not_full.notify_all();
+#endif
+	}
+
+private:
+#ifdef YOSYS_ENABLE_THREADS
+	std::mutex mutex;
+	std::condition_variable not_empty, not_full;
+#endif
+	std::deque<T> items;
+	size_t capacity;
+	bool closed = false;
+};
+
+// A set of worker threads that all run the same function, which gets the
+// worker index as argument. The destructor waits for all workers.
+//
+// Without thread support no worker is started and num_threads() returns 0,
+// so callers always have to be able to do the work on the calling thread.
+class ThreadPool
+{
+public:
+	// Number of workers to use for `work_items` independent work items,
+	// leaving `reserved_cores` cores for other threads. Honors the
+	// YOSYS_MAX_THREADS environment variable. Returns 0 if threads are not
+	// available.
+	static int pool_size(int reserved_cores, int work_items);
+
+	ThreadPool(int num_threads, std::function<void(int)> body);
+	~ThreadPool();
+
+	int num_threads() const;
+	void join();
+
+private:
+#ifdef YOSYS_ENABLE_THREADS
+	std::vector<std::thread> threads;
+#endif
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
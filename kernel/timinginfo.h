@@ -51,7 +51,7 @@ struct TimingInfo
 	{
 		dict<BitBit, int> comb;
 		dict<NameBit, std::pair<int,NameBit>> arrival, required;
-		bool has_inputs;
+		bool has_inputs = false;
 	};
 
 	dict<RTLIL::IdString, ModuleTiming> data;
@@ -0,0 +1,118 @@
+/*
+ *  ezSAT -- A simple and easy to use CNF generator for SAT solvers
+ *
+ *  Copyright (C) 2013  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "ezipasir.h"
+
+#include <stdlib.h>
+
+extern "C" {
+	const char *ipasir_signature();
+	void *ipasir_init();
+	void ipasir_release(void *solver);
+	void ipasir_add(void *solver, int lit_or_zero);
+	void ipasir_assume(void *solver, int lit);
+	int ipasir_solve(void *solver);
+	int ipasir_val(void *solver, int lit);
+	void ipasir_set_terminate(void *solver, void *data, int (*terminate)(void *data));
+}
+
+ezIpasirSAT::ezIpasirSAT() : ipasirSolver(NULL), terminateTimeout(0)
+{
+}
+
+ezIpasirSAT::~ezIpasirSAT()
+{
+	if (ipasirSolver != NULL)
+		ipasir_release(ipasirSolver);
+}
+
+void ezIpasirSAT::clear()
+{
+	if (ipasirSolver != NULL) {
+		ipasir_release(ipasirSolver);
+		ipasirSolver = NULL;
+	}
+	ezSAT::clear();
+}
+
+const char *ezIpasirSAT::signature()
+{
+	return ipasir_signature();
+}
+
+int ezIpasirSAT::terminateCallback(void *data)
+{
+	ezIpasirSAT *that = (ezIpasirSAT*)data;
+	return that->terminateTimeout != 0 && clock() > that->terminateTimeout;
+}
+
+bool ezIpasirSAT::solver(const std::vector<int> &modelExpressions, std::vector<bool> &modelValues, const std::vector<int> &assumptions)
+{
+	preSolverCallback();
+
+	solverTimoutStatus = false;
+
+	std::vector<int> extraClauses, modelIdx;
+
+	for (auto id : assumptions)
+		extraClauses.push_back(bind(id));
+	for (auto id : modelExpressions)
+		modelIdx.push_back(bind(id));
+
+	if (ipasirSolver == NULL) {
+		ipasirSolver = ipasir_init();
+		ipasir_set_terminate(ipasirSolver, this, terminateCallback);
+	}
+
+	// IPASIR solvers keep all variables unless they are told otherwise, so
+	// unlike with MiniSAT there is no need to freeze anything and the ezSAT
+	// CNF variable indices can be used as solver literals directly.
+	std::vector<std::vector<int>> cnf;
+	consumeCnf(cnf);
+
+	for (auto &clause : cnf) {
+		for (auto idx : clause)
+			ipasir_add(ipasirSolver, idx);
+		ipasir_add(ipasirSolver, 0);
+	}
+
+	for (auto idx : extraClauses)
+		ipasir_assume(ipasirSolver, idx);
+
+	terminateTimeout = solverTimeout > 0 ? clock() + solverTimeout*CLOCKS_PER_SEC : 0;
+	int result = ipasir_solve(ipasirSolver);
+
+	if (result == 0)
+		solverTimoutStatus = true;
+
+	if (result != 10)
+		return false;
+
+	modelValues.clear();
+	modelValues.resize(modelIdx.size());
+
+	for (size_t i = 0; i < modelIdx.size(); i++)
+	{
+		int idx = modelIdx[i];
+		bool value = ipasir_val(ipasirSolver, abs(idx)) > 0;
+		modelValues[i] = idx > 0 ? value : !value;
+	}
+
+	return true;
+}
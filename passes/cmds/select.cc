@@ -54,6 +54,13 @@ static bool match_ids(RTLIL::IdString id, const std::string &pattern)
 	return false;
 }
 
+// A pattern without wildcards, escapes or a leading '$' can only match the
+// public name "\\<pattern>" in match_ids(), so it can be looked up directly.
+static bool is_literal_pattern(const std::string &pattern)
+{
+	return !pattern.empty() && pattern[0] != '$' && pattern.find_first_of("*?[\\") == std::string::npos;
+}
+
 static bool match_attr_val(const RTLIL::Const &value, const std::string &pattern, char match_op)
 {
 	if (match_op == 0)
@@ -431,7 +438,52 @@ static int parse_comma_list(std::set<RTLIL::IdString> &tokens, const std::string
 	}
 }
 
-static int select_op_expand(RTLIL::Design *design, RTLIL::Selection &lhs, std::vector<expand_rule_t> &rules, std::set<RTLIL::IdString> &limits, int max_objects, char mode, CellTypes &ct, bool eval_only)
+// Connectivity of a module, built once per expand operator. Objects selected
+// in one level have all their neighbours selected in the next one, so after
+// the first level only the neighbours of the previous level's new objects
+// need to be looked at.
+struct expand_index_t
+{
+	std::vector<RTLIL::Cell*> cells;
+	dict<RTLIL::Cell*, int> cell_index;
+	dict<RTLIL::Wire*, std::vector<int>> wire_cells;
+	std::vector<std::pair<RTLIL::SigBit, RTLIL::SigBit>> conn_bits;
+	dict<RTLIL::Wire*, std::vector<int>> wire_conns;
+	pool<RTLIL::IdString> last_added;
+	bool first_level = true;
+
+	expand_index_t(RTLIL::Module *mod)
+	{
+		for (auto cell : mod->cells()) {
+			int idx = GetSize(cells);
+			cells.push_back(cell);
+			cell_index[cell] = idx;
+			for (auto &conn : cell->connections())
+				for (auto &chunk : conn.second.chunks())
+					if (chunk.wire != nullptr) {
+						auto &list = wire_cells[chunk.wire];
+						if (list.empty() || list.back() != idx)
+							list.push_back(idx);
+					}
+		}
+
+		for (auto &conn : mod->connections()) {
+			std::vector<RTLIL::SigBit> conn_lhs = conn.first.to_sigbit_vector();
+			std::vector<RTLIL::SigBit> conn_rhs = conn.second.to_sigbit_vector();
+			for (size_t i = 0; i < conn_lhs.size(); i++) {
+				if (conn_lhs[i].wire == nullptr || conn_rhs[i].wire == nullptr)
+					continue;
+				int idx = GetSize(conn_bits);
+				conn_bits.emplace_back(conn_lhs[i], conn_rhs[i]);
+				wire_conns[conn_lhs[i].wire].push_back(idx);
+				if (conn_rhs[i].wire != conn_lhs[i].wire)
+					wire_conns[conn_rhs[i].wire].push_back(idx);
+			}
+		}
+	}
+};
+
+static int select_op_expand(RTLIL::Design *design, RTLIL::Selection &lhs, std::vector<expand_rule_t> &rules, std::set<RTLIL::IdString> &limits, int max_objects, char mode, CellTypes &ct, bool eval_only, dict<RTLIL::Module*, std::unique_ptr<expand_index_t>> &index)
 {
 	int sel_objects = 0;
 	bool is_input, is_output;
@@ -440,31 +492,76 @@ static int select_op_expand(RTLIL::Design *design, RTLIL::Selection &lhs, std::v
 		if (lhs.selected_whole_module(mod->name) || !lhs.selected_module(mod->name))
 			continue;
 
-		std::set<RTLIL::Wire*> selected_wires;
-		auto selected_members = lhs.selected_members[mod->name];
+		auto &mod_index = index[mod];
+		if (mod_index == nullptr)
+			mod_index.reset(new expand_index_t(mod));
+		auto &idx = *mod_index;
+
+		// Membership tests below are against the selection at the start of
+		// this level, i.e. the current selection minus what was added here.
+		auto &members = lhs.selected_members[mod->name];
+		pool<RTLIL::IdString> added;
+		auto selected = [&](RTLIL::IdString name) {
+			return members.count(name) > 0 && added.count(name) == 0;
+		};
+		auto select = [&](RTLIL::IdString name) {
+			if (members.insert(name).second)
+				added.insert(name);
+			sel_objects++, max_objects--;
+		};
+
+		std::vector<RTLIL::Wire*> frontier_wires;
+		std::vector<int> frontier_cells;
+		if (idx.first_level) {
+			for (auto wire : mod->wires())
+				if (members.count(wire->name))
+					frontier_wires.push_back(wire);
+			for (int i = 0; i < GetSize(idx.cells); i++)
+				if (members.count(idx.cells[i]->name))
+					frontier_cells.push_back(i);
+		} else {
+			for (auto &name : idx.last_added) {
+				if (RTLIL::Wire *wire = mod->wire(name))
+					frontier_wires.push_back(wire);
+				else if (RTLIL::Cell *cell = mod->cell(name))
+					frontier_cells.push_back(idx.cell_index.at(cell));
+			}
+		}
+
+		std::vector<int> conn_candidates;
+		for (auto wire : frontier_wires) {
+			if (limits.count(wire->name))
+				continue;
+			auto it = idx.wire_cells.find(wire);
+			if (it != idx.wire_cells.end())
+				frontier_cells.insert(frontier_cells.end(), it->second.begin(), it->second.end());
+			auto jt = idx.wire_conns.find(wire);
+			if (jt != idx.wire_conns.end())
+				conn_candidates.insert(conn_candidates.end(), jt->second.begin(), jt->second.end());
+		}
+		std::sort(frontier_cells.begin(), frontier_cells.end());
+		frontier_cells.erase(std::unique(frontier_cells.begin(), frontier_cells.end()), frontier_cells.end());
+		std::sort(conn_candidates.begin(), conn_candidates.end());
+		conn_candidates.erase(std::unique(conn_candidates.begin(), conn_candidates.end()), conn_candidates.end());
 
-		for (auto wire : mod->wires())
-			if (lhs.selected_member(mod->name, wire->name) && limits.count(wire->name) == 0)
-				selected_wires.insert(wire);
+		auto wire_selected = [&](RTLIL::Wire *wire) {
+			return selected(wire->name) && limits.count(wire->name) == 0;
+		};
 
-		for (auto &conn : mod->connections())
+		for (int i : conn_candidates)
 		{
-			std::vector<RTLIL::SigBit> conn_lhs = conn.first.to_sigbit_vector();
-			std::vector<RTLIL::SigBit> conn_rhs = conn.second.to_sigbit_vector();
-
-			for (size_t i = 0; i < conn_lhs.size(); i++) {
-				if (conn_lhs[i].wire == nullptr || conn_rhs[i].wire == nullptr)
-					continue;
-				if (mode != 'i' && selected_wires.count(conn_rhs[i].wire) && selected_members.count(conn_lhs[i].wire->name) == 0)
-					lhs.selected_members[mod->name].insert(conn_lhs[i].wire->name), sel_objects++, max_objects--;
-				if (mode != 'o' && selected_wires.count(conn_lhs[i].wire) && selected_members.count(conn_rhs[i].wire->name) == 0)
-					lhs.selected_members[mod->name].insert(conn_rhs[i].wire->name), sel_objects++, max_objects--;
-			}
+			const auto &conn_lhs = idx.conn_bits[i].first;
+			const auto &conn_rhs = idx.conn_bits[i].second;
+			if (mode != 'i' && wire_selected(conn_rhs.wire) && !selected(conn_lhs.wire->name))
+				select(conn_lhs.wire->name);
+			if (mode != 'o' && wire_selected(conn_lhs.wire) && !selected(conn_rhs.wire->name))
+				select(conn_rhs.wire->name);
 		}
 
-		for (auto cell : mod->cells())
-		for (auto &conn : cell->connections())
+		for (int i : frontier_cells)
+		for (auto &conn : idx.cells[i]->connections())
 		{
+			RTLIL::Cell *cell = idx.cells[i];
 			char last_mode = '-';
 			if (eval_only && !yosys_celltypes.cell_evaluable(cell->type))
 				goto exclude_match;
@@ -486,15 +583,18 @@ static int select_op_expand(RTLIL::Design *design, RTLIL::Selection &lhs, std::v
 			is_output = mode == 'x' || ct.cell_output(cell->type, conn.first);
 			for (auto &chunk : conn.second.chunks())
 				if (chunk.wire != nullptr) {
-					if (max_objects != 0 && selected_wires.count(chunk.wire) > 0 && selected_members.count(cell->name) == 0)
+					if (max_objects != 0 && wire_selected(chunk.wire) && !selected(cell->name))
 						if (mode == 'x' || (mode == 'i' && is_output) || (mode == 'o' && is_input))
-							lhs.selected_members[mod->name].insert(cell->name), sel_objects++, max_objects--;
-					if (max_objects != 0 && selected_members.count(cell->name) > 0 && limits.count(cell->name) == 0 && selected_members.count(chunk.wire->name) == 0)
+							select(cell->name);
+					if (max_objects != 0 && selected(cell->name) && limits.count(cell->name) == 0 && !selected(chunk.wire->name))
 						if (mode == 'x' || (mode == 'i' && is_input) || (mode == 'o' && is_output))
-							lhs.selected_members[mod->name].insert(chunk.wire->name), sel_objects++, max_objects--;
+							select(chunk.wire->name);
 				}
 		exclude_match:;
 		}
+
+		idx.last_added.swap(added);
+		idx.first_level = false;
 	}
 
 	return sel_objects;
@@ -593,8 +693,9 @@ static void select_op_expand(RTLIL::Design *design, const std::string &arg, char
 	}
 #endif
 
+	dict<RTLIL::Module*, std::unique_ptr<expand_index_t>> index;
 	while (levels-- > 0 && rem_objects != 0) {
-		int num_objects = select_op_expand(design, work_stack.back(), rules, limits, rem_objects, mode, ct, eval_only);
+		int num_objects = select_op_expand(design, work_stack.back(), rules, limits, rem_objects, mode, ct, eval_only, index);
 		if (num_objects == 0)
 			break;
 		rem_objects -= num_objects;
@@ -805,6 +906,7 @@ static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_emp
 	}
 
 	sel.full_selection = false;
+	dict<RTLIL::IdString, bool> type_matches;
 	for (auto mod : design->modules())
 	{
 		if (!select_blackboxes && mod->get_blackbox_attribute())
@@ -829,6 +931,11 @@ static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_emp
 		}
 
 		if (arg_memb.compare(0, 2, "w:") == 0) {
+			if (is_literal_pattern(arg_memb.substr(2))) {
+				RTLIL::Wire *wire = mod->wire("\\" + arg_memb.substr(2));
+				if (wire != nullptr)
+					sel.selected_members[mod->name].insert(wire->name);
+			} else
 			for (auto wire : mod->wires())
 				if (match_ids(wire->name, arg_memb.substr(2)))
 					sel.selected_members[mod->name].insert(wire->name);
@@ -871,14 +978,24 @@ static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_emp
 					sel.selected_members[mod->name].insert(it.first);
 		} else
 		if (arg_memb.compare(0, 2, "c:") == 0) {
+			if (is_literal_pattern(arg_memb.substr(2))) {
+				RTLIL::Cell *cell = mod->cell("\\" + arg_memb.substr(2));
+				if (cell != nullptr)
+					sel.selected_members[mod->name].insert(cell->name);
+			} else
 			for (auto cell : mod->cells())
 				if (match_ids(cell->name, arg_memb.substr(2)))
 					sel.selected_members[mod->name].insert(cell->name);
 		} else
 		if (arg_memb.compare(0, 2, "t:") == 0) {
-			for (auto cell : mod->cells())
-				if (match_ids(cell->type, arg_memb.substr(2)))
+			// Many cells share a type, only match each type once.
+			for (auto cell : mod->cells()) {
+				auto it = type_matches.find(cell->type);
+				if (it == type_matches.end())
+					it = type_matches.emplace(cell->type, match_ids(cell->type, arg_memb.substr(2))).first;
+				if (it->second)
 					sel.selected_members[mod->name].insert(cell->name);
+			}
 		} else
 		if (arg_memb.compare(0, 2, "p:") == 0) {
 			for (auto &it : mod->processes)
@@ -907,6 +1024,14 @@ static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_emp
 			std::string orig_arg_memb = arg_memb;
 			if (arg_memb.compare(0, 2, "n:") == 0)
 				arg_memb = arg_memb.substr(2);
+			if (is_literal_pattern(arg_memb)) {
+				RTLIL::IdString id = "\\" + arg_memb;
+				if (mod->wire(id) != nullptr || mod->memories.count(id) || mod->cell(id) != nullptr || mod->processes.count(id)) {
+					sel.selected_members[mod->name].insert(id);
+					arg_memb_found[orig_arg_memb] = true;
+				}
+				continue;
+			}
 			for (auto wire : mod->wires())
 				if (match_ids(wire->name, arg_memb)) {
 					sel.selected_members[mod->name].insert(wire->name);
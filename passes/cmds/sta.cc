@@ -21,7 +21,6 @@
 #include "kernel/yosys.h"
 #include "kernel/sigtools.h"
 #include "kernel/timinginfo.h"
-#include <deque>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -32,29 +31,51 @@ struct StaWorker
 	Module *module;
 	SigMap sigmap;
 
-	struct t_data {
-		Cell* driver;
-		IdString dst_port, src_port;
-		vector<tuple<SigBit,int,IdString>> fanouts;
-		SigBit backtrack;
-		t_data() : driver(nullptr) {}
+	// The timing graph has one node per (sigmapped) bit, with dense indices
+	// from bits. All per-node data lives in vectors indexed the same way.
+	struct t_arc {
+		int dst;
+		int delay;
+		IdString src_port;
 	};
-	dict<SigBit, t_data> data;
-	std::deque<SigBit> queue;
-	struct t_endpoint {
+	struct t_node {
+		Cell* driver;
+		IdString dst_port;
+		vector<t_arc> fanouts;
+		int num_fanins;
+		bool driven;
+		bool is_endpoint;
 		Cell *sink;
 		IdString port;
 		int required;
-		t_endpoint() : sink(nullptr), required(0) {}
+		t_node() : driver(nullptr), num_fanins(0), driven(false), is_endpoint(false), sink(nullptr), required(0) {}
 	};
-	dict<SigBit, t_endpoint> endpoints;
-
+	idict<SigBit> bits;
+	vector<t_node> nodes;
+	vector<int> sources;
+
+	// Filled in by run()
+	vector<int> order;
+	vector<int> arrival, required, backtrack;
+	vector<IdString> src_port;
 	int maxarrival;
-	SigBit maxbit;
+	int maxnode;
 
-	pool<SigBit> driven;
+	int node(SigBit bit)
+	{
+		int idx = bits(bit);
+		if (idx == GetSize(nodes))
+			nodes.emplace_back();
+		return idx;
+	}
+
+	void add_arc(int src, int dst, int delay, IdString src_port)
+	{
+		nodes[src].fanouts.push_back(t_arc{dst, delay, src_port});
+		nodes[dst].num_fanins++;
+	}
 
-	StaWorker(RTLIL::Module *module) : design(module->design), module(module), sigmap(module), maxarrival(0)
+	StaWorker(RTLIL::Module *module) : design(module->design), module(module), sigmap(module), maxarrival(0), maxnode(-1)
 	{
 		TimingInfo timing;
 
@@ -88,7 +109,7 @@ struct StaWorker
 			if (t.comb.empty() && t.arrival.empty() && t.required.empty())
 				continue;
 
-			pool<std::pair<SigBit,TimingInfo::NameBit>> src_bits, dst_bits;
+			pool<std::pair<int,TimingInfo::NameBit>> src_bits, dst_bits;
 
 			for (auto &conn : cell->connections()) {
 				auto rhs = sigmap(conn.second);
@@ -98,24 +119,27 @@ struct StaWorker
 						continue;
 					TimingInfo::NameBit namebit(conn.first,i);
 					if (cell->input(conn.first)) {
-						src_bits.insert(std::make_pair(bit,namebit));
+						int n = node(bit);
+						src_bits.insert(std::make_pair(n,namebit));
 
 						auto it = t.required.find(namebit);
 						if (it == t.required.end())
 							continue;
-						auto r = endpoints.insert(bit);
-						if (r.second || r.first->second.required < it->second.first) {
-							r.first->second.sink = cell;
-							r.first->second.port = conn.first;
-							r.first->second.required = it->second.first;
+						auto &e = nodes[n];
+						if (!e.is_endpoint || e.required < it->second.first) {
+							e.is_endpoint = true;
+							e.sink = cell;
+							e.port = conn.first;
+							e.required = it->second.first;
 						}
 					}
 					if (cell->output(conn.first)) {
-						dst_bits.insert(std::make_pair(bit,namebit));
-						auto &d = data[bit];
+						int n = node(bit);
+						dst_bits.insert(std::make_pair(n,namebit));
+						auto &d = nodes[n];
 						d.driver = cell;
 						d.dst_port = conn.first;
-						driven.insert(bit);
+						d.driven = true;
 
 						auto it = t.arrival.find(namebit);
 						if (it == t.arrival.end())
@@ -124,7 +148,7 @@ struct StaWorker
 						if (cell->hasPort(s.name)) {
 							auto s_bit = sigmap(cell->getPort(s.name)[s.offset]);
 							if (s_bit.wire)
-								data[s_bit].fanouts.emplace_back(bit,it->second.first,s.name);
+								add_arc(node(s_bit), n, it->second.first, s.name);
 						}
 					}
 				}
@@ -135,7 +159,7 @@ struct StaWorker
 					auto it = t.comb.find(TimingInfo::BitBit(s.second,d.second));
 					if (it == t.comb.end())
 						continue;
-					data[s.first].fanouts.emplace_back(d.first,it->second,s.second.name);
+					add_arc(s.first, d.first, it->second, s.second.name);
 				}
 		}
 
@@ -143,8 +167,9 @@ struct StaWorker
 			auto wire = module->wire(port_name);
 			if (wire->port_input) {
 				for (const auto &b : sigmap(wire)) {
-					queue.emplace_back(b);
-					driven.insert(b);
+					int n = node(b);
+					sources.push_back(n);
+					nodes[n].driven = true;
 				}
 				// All primary inputs to arrive at time zero
 				wire->set_intvec_attribute(ID::sta_arrival, std::vector<int>(GetSize(wire), 0));
@@ -152,98 +177,151 @@ struct StaWorker
 			if (wire->port_output)
 				for (const auto &b : sigmap(wire))
 					if (b.wire)
-						endpoints.insert(b);
+						nodes[node(b)].is_endpoint = true;
 		}
 	}
 
-	void run()
+	// Sorts the nodes into levels, so that each node comes after all of its
+	// fanins. Nodes on combinational loops are left out.
+	void levelise()
 	{
-		while (!queue.empty()) {
-			auto b = queue.front();
-			queue.pop_front();
-			auto it = data.find(b);
-			if (it == data.end())
+		vector<int> num_fanins(GetSize(nodes));
+		order.clear();
+		order.reserve(GetSize(nodes));
+		for (int i = 0; i < GetSize(nodes); i++) {
+			num_fanins[i] = nodes[i].num_fanins;
+			if (num_fanins[i] == 0)
+				order.push_back(i);
+		}
+		for (int i = 0; i < GetSize(order); i++)
+			for (const auto &arc : nodes[order[i]].fanouts)
+				if (--num_fanins[arc.dst] == 0)
+					order.push_back(arc.dst);
+		if (GetSize(order) < GetSize(nodes))
+			log_warning("Ignoring %d bits on combinational loops in module '%s'.\n", GetSize(nodes) - GetSize(order), log_id(module));
+	}
+
+	void propagate_arrival()
+	{
+		arrival.assign(GetSize(nodes), -1);
+		backtrack.assign(GetSize(nodes), -1);
+		src_port.assign(GetSize(nodes), IdString());
+		for (int n : sources)
+			arrival[n] = 0;
+
+		for (int n : order) {
+			if (arrival[n] < 0)
 				continue;
-			const auto& src_arrivals = b.wire->get_intvec_attribute(ID::sta_arrival);
-			log_assert(GetSize(src_arrivals) == GetSize(b.wire));
-			auto src_arrival = src_arrivals[b.offset];
-			for (const auto &d : it->second.fanouts) {
-				const auto &dst_bit = std::get<0>(d);
-				auto dst_arrivals = dst_bit.wire->get_intvec_attribute(ID::sta_arrival);
-				if (dst_arrivals.empty())
-					dst_arrivals = std::vector<int>(GetSize(dst_bit.wire), -1);
-				else
-					log_assert(GetSize(dst_arrivals) == GetSize(dst_bit.wire));
-				auto &dst_arrival = dst_arrivals[dst_bit.offset];
-				auto new_arrival = src_arrival + std::get<1>(d);
-				if (dst_arrival < new_arrival) {
-					auto dst_wire = dst_bit.wire;
-					dst_arrival = std::max(dst_arrival, new_arrival);
-					dst_wire->set_intvec_attribute(ID::sta_arrival, dst_arrivals);
-					queue.emplace_back(dst_bit);
-
-					data[dst_bit].backtrack = b;
-					data[dst_bit].src_port = std::get<2>(d);
-
-					auto it = endpoints.find(dst_bit);
-					if (it != endpoints.end())
-						new_arrival += it->second.required;
-					if (new_arrival > maxarrival && driven.count(b)) {
-						maxarrival = new_arrival;
-						maxbit = dst_bit;
-					}
+			for (const auto &arc : nodes[n].fanouts) {
+				auto new_arrival = arrival[n] + arc.delay;
+				if (arrival[arc.dst] < new_arrival) {
+					arrival[arc.dst] = new_arrival;
+					backtrack[arc.dst] = n;
+					src_port[arc.dst] = arc.src_port;
 				}
 			}
 		}
 
-		auto b = maxbit;
-		if (b == SigBit()) {
-			log("No timing paths found.\n");
-			return;
+		for (int n : order) {
+			if (backtrack[n] < 0)
+				continue;
+			auto end_arrival = arrival[n];
+			if (nodes[n].is_endpoint)
+				end_arrival += nodes[n].required;
+			if (end_arrival > maxarrival) {
+				maxarrival = end_arrival;
+				maxnode = n;
+			}
 		}
+	}
 
-		log("Latest arrival time in '%s' is %d:\n", log_id(module), maxarrival);
-		auto it = endpoints.find(maxbit);
-		if (it != endpoints.end() && it->second.sink)
-			log("  %6d %s (%s.%s)\n", maxarrival, log_id(it->second.sink), log_id(it->second.sink->type), log_id(it->second.port));
+	// Required times are relative to a common target delay, endpoints with
+	// a required time (setup) at a cell input need their data that much
+	// earlier. Nodes that reach no endpoint stay at INT_MAX.
+	void propagate_required(int target)
+	{
+		required.assign(GetSize(nodes), INT_MAX);
+		for (int i = 0; i < GetSize(nodes); i++)
+			if (nodes[i].is_endpoint)
+				required[i] = target - nodes[i].required;
+
+		for (int i = GetSize(order)-1; i >= 0; i--) {
+			int n = order[i];
+			for (const auto &arc : nodes[n].fanouts)
+				if (required[arc.dst] != INT_MAX)
+					required[n] = std::min(required[n], required[arc.dst] - arc.delay);
+		}
+	}
+
+	void annotate_arrival()
+	{
+		dict<Wire*, vector<int>> wire_arrivals;
+		for (int n = 0; n < GetSize(nodes); n++) {
+			if (arrival[n] < 0)
+				continue;
+			const SigBit &b = bits[n];
+			auto &arrivals = wire_arrivals[b.wire];
+			if (arrivals.empty())
+				arrivals.resize(GetSize(b.wire), -1);
+			arrivals[b.offset] = arrival[n];
+		}
+		for (auto &it : wire_arrivals)
+			it.first->set_intvec_attribute(ID::sta_arrival, it.second);
+	}
+
+	void log_path(int n, bool warn_unknown)
+	{
+		const auto &e = nodes[n];
+		auto end_arrival = arrival[n] + (e.is_endpoint ? e.required : 0);
+		if (e.is_endpoint && e.sink)
+			log("  %6d %s (%s.%s)\n", end_arrival, log_id(e.sink), log_id(e.sink->type), log_id(e.port));
 		else {
-			log("  %6d (%s)\n", maxarrival, b.wire->port_output ? "<primary output>" : "<unknown>");
-			if (!b.wire->port_output)
+			SigBit b = bits[n];
+			log("  %6d (%s)\n", end_arrival, b.wire->port_output ? "<primary output>" : "<unknown>");
+			if (!b.wire->port_output && warn_unknown)
 				log_warning("Critical-path does not terminate in a recognised endpoint.\n");
 		}
-		auto jt = data.find(b);
-		while (jt != data.end()) {
-			int arrival = b.wire->get_intvec_attribute(ID::sta_arrival)[b.offset];
-			if (jt->second.driver) {
+		while (n >= 0) {
+			SigBit b = bits[n];
+			if (nodes[n].driver) {
 				log("           %s\n", log_signal(b));
-				log("  %6d %s (%s.%s->%s)\n", arrival, log_id(jt->second.driver), log_id(jt->second.driver->type), log_id(jt->second.src_port), log_id(jt->second.dst_port));
+				log("  %6d %s (%s.%s->%s)\n", arrival[n], log_id(nodes[n].driver), log_id(nodes[n].driver->type), log_id(src_port[n]), log_id(nodes[n].dst_port));
 			}
 			else if (b.wire->port_input)
-				log("  %6d   %s (%s)\n", arrival, log_signal(b), "<primary input>");
+				log("  %6d   %s (%s)\n", arrival[n], log_signal(b), "<primary input>");
 			else
 				log_abort();
-			b = jt->second.backtrack;
-			jt = data.find(b);
+			n = backtrack[n];
 		}
+	}
 
-		std::map<int, unsigned> arrival_histogram;
-		for (const auto &i : endpoints) {
-			const auto &b = i.first;
-			if (!driven.count(b))
-				continue;
+	void run(int target, int num_paths)
+	{
+		levelise();
+		propagate_arrival();
+		annotate_arrival();
+
+		if (maxnode < 0) {
+			log("No timing paths found.\n");
+			return;
+		}
+
+		log("Latest arrival time in '%s' is %d:\n", log_id(module), maxarrival);
+		log_path(maxnode, true);
 
-			if (!b.wire->attributes.count(ID::sta_arrival)) {
-				log_warning("Endpoint %s.%s has no (* sta_arrival *) value.\n", log_id(module), log_signal(b));
+		std::map<int, unsigned> arrival_histogram;
+		vector<int> endpoints;
+		for (int n = 0; n < GetSize(nodes); n++) {
+			const auto &e = nodes[n];
+			if (!e.is_endpoint || !e.driven)
 				continue;
-			}
 
-			auto arrival = b.wire->get_intvec_attribute(ID::sta_arrival)[b.offset];
-			if (arrival < 0) {
-				log_warning("Endpoint %s.%s has no (* sta_arrival *) value.\n", log_id(module), log_signal(b));
+			if (arrival[n] < 0) {
+				log_warning("Endpoint %s.%s has no (* sta_arrival *) value.\n", log_id(module), log_signal(bits[n]));
 				continue;
 			}
-			arrival += i.second.required;
-			arrival_histogram[arrival]++;
+			arrival_histogram[arrival[n] + e.required]++;
+			endpoints.push_back(n);
 		}
 		// Adapted from https://github.com/YosysHQ/nextpnr/blob/affb12cc27ebf409eade062c4c59bb98569d8147/common/timing.cc#L946-L969
 		if (arrival_histogram.size() > 0) {
@@ -270,6 +348,34 @@ struct StaWorker
 						std::string(bins[i] * bar_width / max_freq, '*').c_str(),
 						(bins[i] * bar_width) % max_freq > 0 ? '+' : ' ');
 		}
+
+		if (num_paths <= 0 || endpoints.empty())
+			return;
+
+		if (target < 0)
+			target = maxarrival;
+		propagate_required(target);
+
+		// Slack of an endpoint is the same for all paths ending there, report
+		// the worst path into each of the worst endpoints.
+		std::stable_sort(endpoints.begin(), endpoints.end(), [&](int a, int b) {
+			return required[a] - arrival[a] < required[b] - arrival[b];
+		});
+		if (GetSize(endpoints) > num_paths)
+			endpoints.resize(num_paths);
+
+		int num_violated = 0;
+		for (int n : endpoints)
+			if (required[n] < arrival[n])
+				num_violated++;
+
+		log("\n");
+		log("Worst %d endpoint(s) for target delay %d (%d with negative slack):\n", GetSize(endpoints), target, num_violated);
+		for (int n : endpoints) {
+			log("\n");
+			log("Slack %d (required %d, arrival %d) at %s:\n", required[n] - arrival[n], required[n], arrival[n], log_signal(bits[n]));
+			log_path(n, false);
+		}
 	}
 };
 
@@ -284,22 +390,34 @@ struct StaPass : public Pass {
 		log("This command performs static timing analysis on the design. (Only considers\n");
 		log("paths within a single module, so the design must be flattened.)\n");
 		log("\n");
+		log("    -T <delay>\n");
+		log("        target delay for the slack computation. Defaults to the latest\n");
+		log("        arrival time, so that the critical path has a slack of zero.\n");
+		log("\n");
+		log("    -paths <N>\n");
+		log("        report the slack of the N endpoints with the least slack, each with\n");
+		log("        the latest arriving path into it.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		log_header(design, "Executing STA pass (static timing analysis).\n");
 
-		/*
+		int target = -1, num_paths = 0;
+
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
-			if (args[argidx] == "-TODO") {
+			if (args[argidx] == "-T" && argidx+1 < args.size()) {
+				target = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-paths" && argidx+1 < args.size()) {
+				num_paths = atoi(args[++argidx].c_str());
 				continue;
 			}
 			break;
 		}
-		*/
-
-		extra_args(args, 1, design);
+		extra_args(args, argidx, design);
 
 		for (Module *module : design->selected_modules())
 		{
@@ -307,7 +425,7 @@ struct StaPass : public Pass {
 				continue;
 
 			StaWorker worker(module);
-			worker.run();
+			worker.run(target, num_paths);
 		}
 	}
 } StaPass;
@@ -327,25 +327,49 @@ struct statdata_t
 	}
 };
 
-statdata_t hierarchy_worker(std::map<RTLIL::IdString, statdata_t> &mod_stat, RTLIL::IdString mod, int level, bool quiet = false)
+void hierarchy_log(const std::map<RTLIL::IdString, statdata_t> &mod_stat, RTLIL::IdString mod, int level)
 {
+	for (auto &it : mod_stat.at(mod).num_cells_by_type)
+		if (mod_stat.count(it.first) > 0) {
+			log("     %*s%-*s %6u\n", 2*level, "", 26-2*level, log_id(it.first), it.second);
+			hierarchy_log(mod_stat, it.first, level+1);
+		}
+}
+
+// Each module's flattened statistics are computed once and reused for all of
+// its instances, instead of once per instance path.
+const statdata_t &hierarchy_worker(const std::map<RTLIL::IdString, statdata_t> &mod_stat, RTLIL::IdString mod, dict<RTLIL::IdString, statdata_t> &hier_stat)
+{
+	auto cached = hier_stat.find(mod);
+	if (cached != hier_stat.end())
+		return cached->second;
+
 	statdata_t mod_data = mod_stat.at(mod);
 	std::map<RTLIL::IdString, unsigned int, RTLIL::sort_by_id_str> num_cells_by_type;
 	num_cells_by_type.swap(mod_data.num_cells_by_type);
 
 	for (auto &it : num_cells_by_type)
 		if (mod_stat.count(it.first) > 0) {
-			if (!quiet)
-				log("     %*s%-*s %6u\n", 2*level, "", 26-2*level, log_id(it.first), it.second);
-			mod_data = mod_data + hierarchy_worker(mod_stat, it.first, level+1, quiet) * it.second;
+			mod_data = mod_data + hierarchy_worker(mod_stat, it.first, hier_stat) * it.second;
 			mod_data.num_cells -= it.second;
 		} else {
 			mod_data.num_cells_by_type[it.first] += it.second;
 		}
 
-	return mod_data;
+	return hier_stat.emplace(mod, std::move(mod_data)).first->second;
 }
 
+// Cell areas of previously read liberty files, keyed by file name. Running
+// 'stat -liberty' after every step of a flow only parses the file again when
+// its contents changed.
+struct liberty_area_cache_t {
+	size_t size;
+	size_t hash;
+	dict<IdString, cell_area_t> cell_area;
+};
+
+dict<std::string, liberty_area_cache_t> liberty_area_cache;
+
 void read_liberty_cellarea(dict<IdString, cell_area_t> &cell_area, string liberty_file)
 {
 	std::ifstream f;
@@ -353,19 +377,39 @@ void read_liberty_cellarea(dict<IdString, cell_area_t> &cell_area, string libert
 	yosys_input_files.insert(liberty_file);
 	if (f.fail())
 		log_cmd_error("Can't open liberty file `%s': %s\n", liberty_file.c_str(), strerror(errno));
-	LibertyParser libparser(f);
+	std::stringstream buffer;
+	buffer << f.rdbuf();
 	f.close();
+	std::string content = buffer.str();
 
-	for (auto cell : libparser.ast->children)
+	size_t hash = std::hash<std::string>()(content);
+	auto cached = liberty_area_cache.find(liberty_file);
+	if (cached == liberty_area_cache.end() || cached->second.size != content.size() || cached->second.hash != hash)
 	{
-		if (cell->id != "cell" || cell->args.size() != 1)
-			continue;
+		liberty_area_cache_t entry;
+		entry.size = content.size();
+		entry.hash = hash;
+
+		std::istringstream in(std::move(content));
+		LibertyParser libparser(in);
+
+		for (auto cell : libparser.ast->children)
+		{
+			if (cell->id != "cell" || cell->args.size() != 1)
+				continue;
+
+			LibertyAst *ar = cell->find("area");
+			bool is_flip_flop = cell->find("ff") != nullptr;
+			if (ar != nullptr && !ar->value.empty())
+				entry.cell_area["\\" + cell->args[0]] = {/*area=*/atof(ar->value.c_str()), is_flip_flop};
+		}
 
-		LibertyAst *ar = cell->find("area");
-		bool is_flip_flop = cell->find("ff") != nullptr;
-		if (ar != nullptr && !ar->value.empty())
-			cell_area["\\" + cell->args[0]] = {/*area=*/atof(ar->value.c_str()), is_flip_flop};
+		liberty_area_cache[liberty_file] = std::move(entry);
+		cached = liberty_area_cache.find(liberty_file);
 	}
+
+	for (auto &it : cached->second.cell_area)
+		cell_area[it.first] = it.second;
 }
 
 struct StatPass : public Pass {
@@ -487,9 +531,11 @@ struct StatPass : public Pass {
 				log("=== design hierarchy ===\n");
 				log("\n");
 				log("   %-28s %6d\n", log_id(top_mod->name), 1);
+				hierarchy_log(mod_stat, top_mod->name, 1);
 			}
 
-			statdata_t data = hierarchy_worker(mod_stat, top_mod->name, 0, /*quiet=*/json_mode);
+			dict<RTLIL::IdString, statdata_t> hier_stat;
+			statdata_t data = hierarchy_worker(mod_stat, top_mod->name, hier_stat);
 
 			if (json_mode)
 				data.log_data_json("design", true);
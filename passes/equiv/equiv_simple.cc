@@ -19,34 +19,56 @@
 
 #include "kernel/yosys.h"
 #include "kernel/satgen.h"
+#include "kernel/threading.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
+struct EquivSimpleResult
+{
+	std::string log_output;
+	vector<Cell*> proven_cells;
+	std::string error;
+};
+
+// Workers for different groups of $equiv cells may run on different threads.
+// Everything except the SAT solver calls accesses the design and the log
+// functions, so it runs with design_mutex held. Log output is collected in
+// the group's EquivSimpleResult and printed by the pass afterwards.
 struct EquivSimpleWorker
 {
-	Module *module;
-	const vector<Cell*> &equiv_cells;
 	Cell *equiv_cell;
 
 	SigMap &sigmap;
 	dict<SigBit, Cell*> &bit2driver;
+	Mutex &design_mutex;
 
 	ezSatPtr ez;
 	SatGen satgen;
 	int max_seq;
 	bool short_cones;
 	bool verbose;
+	bool defer_proven;
+
+	EquivSimpleResult *result;
 
 	pool<pair<Cell*, int>> imported_cells_cache;
 
-	EquivSimpleWorker(const vector<Cell*> &equiv_cells, SigMap &sigmap, dict<SigBit, Cell*> &bit2driver, int max_seq, bool short_cones, bool verbose, bool model_undef) :
-			module(equiv_cells.front()->module), equiv_cells(equiv_cells), equiv_cell(nullptr),
-			sigmap(sigmap), bit2driver(bit2driver), satgen(ez.get(), &sigmap), max_seq(max_seq), short_cones(short_cones), verbose(verbose)
+	EquivSimpleWorker(SigMap &sigmap, dict<SigBit, Cell*> &bit2driver, Mutex &design_mutex, int max_seq, bool short_cones, bool verbose, bool model_undef, bool defer_proven) :
+			equiv_cell(nullptr), sigmap(sigmap), bit2driver(bit2driver), design_mutex(design_mutex), satgen(ez.get(), &sigmap),
+			max_seq(max_seq), short_cones(short_cones), verbose(verbose), defer_proven(defer_proven), result(nullptr)
 	{
 		satgen.model_undef = model_undef;
 	}
 
+	void log(const char *format, ...) YS_ATTRIBUTE(format(printf, 2, 3))
+	{
+		va_list ap;
+		va_start(ap, format);
+		result->log_output += vstringf(format, ap);
+		va_end(ap);
+	}
+
 	bool find_input_cone(pool<SigBit> &next_seed, pool<Cell*> &cells_cone, pool<SigBit> &bits_cone, const pool<Cell*> &cells_stop, const pool<SigBit> &bits_stop, pool<SigBit> *input_bits, Cell *cell)
 	{
 		if (cells_cone.count(cell))
@@ -90,6 +112,8 @@ struct EquivSimpleWorker
 
 	bool run_cell()
 	{
+		MutexLock lock(design_mutex);
+
 		SigBit bit_a = sigmap(equiv_cell->getPort(ID::A)).as_bit();
 		SigBit bit_b = sigmap(equiv_cell->getPort(ID::B)).as_bit();
 		int ez_context = ez->frozen_literal();
@@ -186,9 +210,10 @@ struct EquivSimpleWorker
 				auto key = pair<Cell*, int>(cell, step+1);
 				if (!imported_cells_cache.count(key) && !satgen.importCell(cell, step+1)) {
 					if (RTLIL::builtin_ff_cell_types().count(cell->type))
-						log_cmd_error("No SAT model available for async FF cell %s (%s).  Consider running `async2sync` or `clk2fflogic` first.\n", log_id(cell), log_id(cell->type));
+						result->error = stringf("No SAT model available for async FF cell %s (%s).  Consider running `async2sync` or `clk2fflogic` first.\n", log_id(cell), log_id(cell->type));
 					else
-						log_cmd_error("No SAT model available for cell %s (%s).\n", log_id(cell), log_id(cell->type));
+						result->error = stringf("No SAT model available for cell %s (%s).\n", log_id(cell), log_id(cell->type));
+					return false;
 				}
 				imported_cells_cache.insert(key);
 			}
@@ -201,9 +226,15 @@ struct EquivSimpleWorker
 			if (verbose)
 				log("    Problem size at t=%d: %d literals, %d clauses\n", step, ez->numCnfVariables(), ez->numCnfClauses());
 
-			if (!ez->solve(ez_context)) {
+			lock.unlock();
+			bool found_model = ez->solve(ez_context);
+			lock.lock();
+
+			if (!found_model) {
 				log(verbose ? "    Proved equivalence! Marking $equiv cell as proven.\n" : " success!\n");
-				equiv_cell->setPort(ID::B, equiv_cell->getPort(ID::A));
+				if (!defer_proven)
+					equiv_cell->setPort(ID::B, equiv_cell->getPort(ID::A));
+				result->proven_cells.push_back(equiv_cell);
 				ez->assume(ez->NOT(ez_context));
 				return true;
 			}
@@ -255,22 +286,24 @@ struct EquivSimpleWorker
 		return false;
 	}
 
-	int run()
+	void run(const vector<Cell*> &equiv_cells, EquivSimpleResult &group_result)
 	{
+		result = &group_result;
+
 		if (GetSize(equiv_cells) > 1) {
+			MutexLock lock(design_mutex);
 			SigSpec sig;
 			for (auto c : equiv_cells)
 				sig.append(sigmap(c->getPort(ID::Y)));
 			log(" Grouping SAT models for %s:\n", log_signal(sig));
 		}
 
-		int counter = 0;
 		for (auto c : equiv_cells) {
 			equiv_cell = c;
-			if (run_cell())
-				counter++;
+			run_cell();
+			if (!result->error.empty())
+				break;
 		}
-		return counter;
 	}
 
 };
@@ -374,6 +407,7 @@ struct EquivSimplePass : public Pass {
 							bit2driver[bit] = cell;
 			}
 
+			vector<vector<Cell*>> groups;
 			unproven_equiv_cells.sort();
 			for (auto it : unproven_equiv_cells)
 			{
@@ -382,9 +416,50 @@ struct EquivSimplePass : public Pass {
 				vector<Cell*> cells;
 				for (auto it2 : it.second)
 					cells.push_back(it2.second);
+				groups.push_back(cells);
+			}
 
-				EquivSimpleWorker worker(cells, sigmap, bit2driver, max_seq, short_cones, verbose, model_undef);
-				success_counter += worker.run();
+			// Groups are split into contiguous ranges that are solved in
+			// parallel. Within a range one SAT instance is reused as long as it
+			// stays small, so cells from overlapping cones are only imported
+			// once. With -short a proven cell changes the cones of the cells
+			// that follow, so those are processed in order on one thread. With
+			// -short and -undef the inputs of each short cone are constrained
+			// to be defined, so every group needs its own SAT instance.
+			int num_threads = short_cones ? 0 : ThreadPool::pool_size(0, GetSize(groups));
+			int num_ranges = max(num_threads, 1);
+			bool share_models = !(short_cones && model_undef);
+			vector<EquivSimpleResult> results(GetSize(groups));
+			Mutex design_mutex;
+
+			auto run_range = [&](int range) {
+				std::unique_ptr<EquivSimpleWorker> worker;
+				int begin = range * GetSize(groups) / num_ranges;
+				int end = (range + 1) * GetSize(groups) / num_ranges;
+				for (int i = begin; i < end; i++) {
+					if (worker == nullptr || !share_models || worker->ez->numCnfVariables() > 100000) {
+						MutexLock lock(design_mutex);
+						worker.reset(new EquivSimpleWorker(sigmap, bit2driver, design_mutex, max_seq, short_cones, verbose, model_undef, num_threads > 0));
+					}
+					worker->run(groups[i], results[i]);
+					if (!results[i].error.empty())
+						break;
+				}
+			};
+
+			ThreadPool pool(num_threads, run_range);
+			if (num_threads == 0)
+				run_range(0);
+			pool.join();
+
+			for (auto &result : results) {
+				log("%s", result.log_output.c_str());
+				if (!result.error.empty())
+					log_cmd_error("%s", result.error.c_str());
+				if (num_threads > 0)
+					for (auto cell : result.proven_cells)
+						cell->setPort(ID::B, cell->getPort(ID::A));
+				success_counter += GetSize(result.proven_cells);
 			}
 		}
 
@@ -67,6 +67,10 @@ struct FsmPass : public Pass {
 		log("    -encfile file\n");
 		log("        passed through to fsm_recode pass\n");
 		log("\n");
+		log("    -max_cubes <N>\n");
+		log("    -timeout <seconds>\n");
+		log("        passed through to fsm_extract pass\n");
+		log("\n");
 		log("This pass uses a subset of FF types to detect FSMs. Run 'opt -nosdff -nodffe'\n");
 		log("before this pass to prepare the design.\n");
 		log("\n");
@@ -88,6 +92,7 @@ struct FsmPass : public Pass {
 		std::string fm_set_fsm_file_opt;
 		std::string encfile_opt;
 		std::string encoding_opt;
+		std::string extract_opts;
 
 		log_header(design, "Executing FSM pass (extract and optimize FSM).\n");
 		log_push();
@@ -107,6 +112,10 @@ struct FsmPass : public Pass {
 				encoding_opt = " -encoding " + args[++argidx];
 				continue;
 			}
+			if ((arg == "-max_cubes" || arg == "-timeout") && argidx+1 < args.size()) {
+				extract_opts += " " + arg + " " + args[++argidx];
+				continue;
+			}
 			if (arg == "-nodetect") {
 				flag_nodetect = true;
 				continue;
@@ -137,7 +146,7 @@ struct FsmPass : public Pass {
 
 		if (!flag_nodetect)
 			Pass::call(design, "fsm_detect");
-		Pass::call(design, "fsm_extract");
+		Pass::call(design, "fsm_extract" + extract_opts);
 
 		Pass::call(design, "fsm_opt");
 		Pass::call(design, "opt_clean");
@@ -38,6 +38,23 @@ typedef std::pair<RTLIL::IdString, RTLIL::IdString> sig2driver_entry_t;
 static SigSet<sig2driver_entry_t> sig2driver, sig2trigger;
 static std::map<RTLIL::SigBit, std::set<RTLIL::SigBit>> exclusive_ctrls;
 
+// Budget for the transition table of one FSM, see -max_cubes and -timeout.
+static int max_cubes, cube_count;
+static int64_t timeout_ns, begin_ns;
+static bool budget_exceeded;
+
+static bool check_budget()
+{
+	if (budget_exceeded)
+		return false;
+	cube_count++;
+	if (max_cubes > 0 && cube_count > max_cubes)
+		budget_exceeded = true;
+	if (timeout_ns > 0 && (cube_count & 255) == 0 && PerformanceTimer::query() - begin_ns > timeout_ns)
+		budget_exceeded = true;
+	return !budget_exceeded;
+}
+
 static bool find_states(RTLIL::SigSpec sig, const RTLIL::SigSpec &dff_out, RTLIL::SigSpec &ctrl, std::map<RTLIL::Const, int> &states, RTLIL::Const *reset_state = NULL)
 {
 	sig.extend_u0(dff_out.size(), false);
@@ -146,6 +163,9 @@ static void find_transitions(ConstEval &ce, ConstEval &ce_nostop, FsmData &fsm_d
 	bool undef_bit_in_next_state_mode = false;
 	RTLIL::SigSpec undef, constval;
 
+	if (!check_budget())
+		return;
+
 	if (ce.eval(ctrl_out, undef) && ce.eval(dff_in, undef))
 	{
 		if (0) {
@@ -358,12 +378,24 @@ static void extract_fsm(RTLIL::Wire *wire)
 
 	ConstEval ce(module), ce_nostop(module);
 	ce.stop(ctrl_in);
+	cube_count = 0;
+	begin_ns = PerformanceTimer::query();
+	budget_exceeded = false;
 	for (int state_idx = 0; state_idx < int(fsm_data.state_table.size()); state_idx++) {
 		ce.push(), ce_nostop.push();
 		ce.set(dff_out, fsm_data.state_table[state_idx]);
 		ce_nostop.set(dff_out, fsm_data.state_table[state_idx]);
 		find_transitions(ce, ce_nostop, fsm_data, states, state_idx, ctrl_in, ctrl_out, dff_in, RTLIL::SigSpec());
 		ce.pop(), ce_nostop.pop();
+		if (budget_exceeded)
+			break;
+	}
+
+	// Nothing has been changed in the module yet, so the state logic is
+	// simply left as it is when the budget is exceeded.
+	if (budget_exceeded) {
+		log("  fsm extraction failed: transition table exceeds the budget after %d input cubes.\n", cube_count);
+		return;
 	}
 
 	// create fsm cell
@@ -405,7 +437,7 @@ struct FsmExtractPass : public Pass {
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
 		log("\n");
-		log("    fsm_extract [selection]\n");
+		log("    fsm_extract [options] [selection]\n");
 		log("\n");
 		log("This pass operates on all signals marked as FSM state signals using the\n");
 		log("'fsm_encoding' attribute. It consumes the logic that creates the state signal\n");
@@ -416,11 +448,41 @@ struct FsmExtractPass : public Pass {
 		log("original encoding. The 'fsm_opt' pass can be used in combination with the\n");
 		log("'opt_clean' pass to eliminate this signal.\n");
 		log("\n");
+		log("The transition table is built by evaluating the state logic for each state\n");
+		log("and each cube of control inputs that the next state and the control outputs\n");
+		log("depend on. For FSMs with many control inputs this can take very long, so the\n");
+		log("number of evaluated cubes per FSM is limited. FSMs that exceed the limit are\n");
+		log("not extracted.\n");
+		log("\n");
+		log("    -max_cubes <N>\n");
+		log("        evaluate at most <N> input cubes per FSM. (default: 100000, 0 means\n");
+		log("        no limit)\n");
+		log("\n");
+		log("    -timeout <seconds>\n");
+		log("        also give up on an FSM when building its transition table takes\n");
+		log("        longer than this. (default: no timeout)\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		log_header(design, "Executing FSM_EXTRACT pass (extracting FSM from design).\n");
-		extra_args(args, 1, design);
+
+		max_cubes = 100000;
+		timeout_ns = 0;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			if (args[argidx] == "-max_cubes" && argidx+1 < args.size()) {
+				max_cubes = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-timeout" && argidx+1 < args.size()) {
+				timeout_ns = int64_t(atof(args[++argidx].c_str()) * 1e9);
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
 
 		CellTypes ct(design);
 
@@ -20,6 +20,8 @@
 #include "memlib.h"
 
 #include <ctype.h>
+#include <fstream>
+#include <sstream>
 
 USING_YOSYS_NAMESPACE
 
@@ -1088,14 +1090,65 @@ struct Parser {
 
 PRIVATE_NAMESPACE_END
 
+// The parsed library only depends on the contents of the files and the
+// defines, synthesis scripts tend to read the same libraries many times.
+struct CachedLibrary {
+	Library lib;
+	pool<std::string> defines_unused;
+};
+
+static dict<std::string, CachedLibrary> library_cache;
+
+static void index_capabilities(Ram &ram) {
+	ram.max_wr_ports = 0;
+	ram.has_async_rd = false;
+	for (auto &pg: ram.port_groups) {
+		bool wr = false;
+		for (auto &pv: pg.variants) {
+			if (pv.kind == PortKind::Sw || pv.kind == PortKind::Srsw || pv.kind == PortKind::Arsw)
+				wr = true;
+			if (pv.kind == PortKind::Ar || pv.kind == PortKind::Arsw)
+				ram.has_async_rd = true;
+		}
+		if (wr)
+			ram.max_wr_ports += GetSize(pg.names);
+	}
+}
+
 Library MemLibrary::parse_library(const std::vector<std::string> &filenames, const pool<std::string> &defines) {
-	Library res;
-	pool<std::string> defines_unused = defines;
+	std::string key;
+	std::vector<std::string> sorted_defines(defines.begin(), defines.end());
+	std::sort(sorted_defines.begin(), sorted_defines.end());
+	for (auto &def: sorted_defines) {
+		key += def;
+		key += '\n';
+	}
 	for (auto &file: filenames) {
-		Parser(file, res, defines, defines_unused);
+		std::string filename = file;
+		rewrite_filename(filename);
+		std::ifstream f(filename, std::ios::binary);
+		if (f.fail()) {
+			log_error("failed to open %s\n", filename.c_str());
+		}
+		std::stringstream content;
+		content << f.rdbuf();
+		key += '\0' + file + '\0' + content.str();
 	}
-	for (auto def: defines_unused) {
+
+	auto it = library_cache.find(key);
+	if (it == library_cache.end()) {
+		CachedLibrary entry;
+		entry.defines_unused = defines;
+		for (auto &file: filenames) {
+			Parser(file, entry.lib, defines, entry.defines_unused);
+		}
+		for (auto &ram: entry.lib.rams)
+			index_capabilities(ram);
+		it = library_cache.emplace(key, std::move(entry)).first;
+	}
+
+	for (auto def: it->second.defines_unused) {
 		log_warning("define %s not used in the library.\n", def.c_str());
 	}
-	return res;
+	return it->second.lib;
 }
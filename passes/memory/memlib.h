@@ -156,6 +156,10 @@ struct Ram {
 	MemoryInitKind init;
 	std::vector<std::string> style;
 	std::vector<RamClock> shared_clocks;
+	// Derived from the port groups, to quickly reject memories that can't
+	// be mapped.
+	int max_wr_ports;
+	bool has_async_rd;
 };
 
 struct Library {
@@ -62,6 +62,8 @@ struct MemQueryCache
 	// An ezSAT variable that is true when we actually care about the data
 	// read from memory (ie. the FF has enable on and is not in reset).
 	int port_ren;
+	// The same as terms for QuickConeSat::can_be_true.
+	std::vector<QuickConeSat::Term> port_ren_terms;
 	// Some caches.
 	dict<std::pair<int, SigBit>, bool> cache_can_collide_rdwr;
 	dict<std::tuple<int, int, SigBit, SigBit>, bool> cache_can_collide_together;
@@ -76,12 +78,14 @@ struct MemQueryCache
 			ren = qcsat.importSigBit(ff.sig_ce);
 			if (!ff.pol_ce)
 				ren = qcsat.ez->NOT(ren);
+			port_ren_terms.push_back(QuickConeSat::any_of(ff.sig_ce, !ff.pol_ce));
 		}
 		if (ff.has_srst) {
 			int nrst = qcsat.importSigBit(ff.sig_srst);
 			if (ff.pol_srst)
 				nrst = qcsat.ez->NOT(nrst);
 			ren = qcsat.ez->AND(ren, nrst);
+			port_ren_terms.push_back(QuickConeSat::any_of(ff.sig_srst, ff.pol_srst));
 		}
 		port_ren = ren;
 	}
@@ -102,10 +106,10 @@ struct MemQueryCache
 		if (it != cache_can_collide_rdwr.end())
 			return it->second;
 		auto &wport = mem.wr_ports[widx];
-		int aeq = addr_eq(port.addr, wport.addr);
-		int wen_sat = qcsat.importSigBit(wen);
-		qcsat.prepare();
-		bool res = qcsat.ez->solve(aeq, wen_sat, port_ren);
+		std::vector<QuickConeSat::Term> terms = port_ren_terms;
+		terms.push_back(QuickConeSat::equal(port.addr, wport.addr));
+		terms.push_back(QuickConeSat::any_of(wen));
+		bool res = qcsat.can_be_true(terms);
 		cache_can_collide_rdwr[key] = res;
 		return res;
 	}
@@ -121,12 +125,12 @@ struct MemQueryCache
 		auto it = cache_can_collide_together.find(key);
 		if (it != cache_can_collide_together.end())
 			return it->second;
-		int aeq1 = addr_eq(port.addr, wport1.addr);
-		int aeq2 = addr_eq(port.addr, wport2.addr);
-		int wen1_sat = qcsat.importSigBit(wen1);
-		int wen2_sat = qcsat.importSigBit(wen2);
-		qcsat.prepare();
-		bool res = qcsat.ez->solve(wen1_sat, wen2_sat, aeq1, aeq2, port_ren);
+		std::vector<QuickConeSat::Term> terms = port_ren_terms;
+		terms.push_back(QuickConeSat::equal(port.addr, wport1.addr));
+		terms.push_back(QuickConeSat::equal(port.addr, wport2.addr));
+		terms.push_back(QuickConeSat::any_of(wen1));
+		terms.push_back(QuickConeSat::any_of(wen2));
+		bool res = qcsat.can_be_true(terms);
 		cache_can_collide_together[key] = res;
 		return res;
 	}
@@ -158,11 +162,9 @@ struct MemQueryCache
 		auto it = cache_impossible_with_ren.find(key);
 		if (it != cache_impossible_with_ren.end())
 			return it->second;
-		int sel_sat = qcsat.importSigBit(sel);
-		if (neg_sel)
-			sel_sat = qcsat.ez->NOT(sel_sat);
-		qcsat.prepare();
-		bool res = !qcsat.ez->solve(port_ren, sel_sat);
+		std::vector<QuickConeSat::Term> terms = port_ren_terms;
+		terms.push_back(QuickConeSat::any_of(sel, neg_sel));
+		bool res = !qcsat.can_be_true(terms);
 		cache_impossible_with_ren[key] = res;
 		return res;
 	}
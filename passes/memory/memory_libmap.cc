@@ -185,7 +185,6 @@ struct MemMapping {
 	double logic_cost;
 	RamKind kind;
 	std::string style;
-	dict<int, int> wr_en_cache;
 	dict<std::pair<int, int>, bool> wr_implies_rd_cache;
 	dict<std::pair<int, int>, bool> wr_excludes_rd_cache;
 	dict<std::pair<int, int>, bool> wr_excludes_srst_cache;
@@ -200,6 +199,10 @@ struct MemMapping {
 			logic_cost = mem.width * mem.size * opts.logic_cost_ram;
 		if (kind == RamKind::Logic)
 			return;
+		bool has_async_rd = false;
+		for (auto &port: mem.rd_ports)
+			if (!port.clk_enable)
+				has_async_rd = true;
 		for (int i = 0; i < GetSize(lib.rams); i++) {
 			auto &rdef = lib.rams[i];
 			if (!check_ram_kind(rdef))
@@ -208,6 +211,14 @@ struct MemMapping {
 				continue;
 			if (!check_init(rdef))
 				continue;
+			if (GetSize(mem.wr_ports) > rdef.max_wr_ports) {
+				log_reject(rdef, "not enough write ports");
+				continue;
+			}
+			if (has_async_rd && !rdef.has_async_rd) {
+				log_reject(rdef, "no asynchronous read ports");
+				continue;
+			}
 			if (rdef.prune_rom && mem.wr_ports.empty()) {
 				log_debug("memory %s.%s: rejecting mapping to %s: ROM mapping disabled (prune_rom set)\n", log_id(mem.module->name), log_id(mem.memid), log_id(rdef.id));
 				continue;
@@ -258,24 +269,12 @@ struct MemMapping {
 		return worker.sigmap_xmux(raddr) == worker.sigmap_xmux(waddr);
 	}
 
-	int get_wr_en(int wpidx) {
-		auto it = wr_en_cache.find(wpidx);
-		if (it != wr_en_cache.end())
-			return it->second;
-		int res = qcsat.ez->expression(qcsat.ez->OpOr, qcsat.importSig(mem.wr_ports[wpidx].en));
-		wr_en_cache.insert({wpidx, res});
-		return res;
-	}
-
 	bool get_wr_implies_rd(int wpidx, int rpidx) {
 		auto key = std::make_pair(wpidx, rpidx);
 		auto it = wr_implies_rd_cache.find(key);
 		if (it != wr_implies_rd_cache.end())
 			return it->second;
-		int wr_en = get_wr_en(wpidx);
-		int rd_en = qcsat.importSigBit(mem.rd_ports[rpidx].en[0]);
-		qcsat.prepare();
-		bool res = !qcsat.ez->solve(wr_en, qcsat.ez->NOT(rd_en));
+		bool res = !qcsat.can_be_true({QuickConeSat::any_of(mem.wr_ports[wpidx].en), QuickConeSat::any_of(mem.rd_ports[rpidx].en[0], true)});
 		wr_implies_rd_cache.insert({key, res});
 		return res;
 	}
@@ -285,10 +284,7 @@ struct MemMapping {
 		auto it = wr_excludes_rd_cache.find(key);
 		if (it != wr_excludes_rd_cache.end())
 			return it->second;
-		int wr_en = get_wr_en(wpidx);
-		int rd_en = qcsat.importSigBit(mem.rd_ports[rpidx].en[0]);
-		qcsat.prepare();
-		bool res = !qcsat.ez->solve(wr_en, rd_en);
+		bool res = !qcsat.can_be_true({QuickConeSat::any_of(mem.wr_ports[wpidx].en), QuickConeSat::any_of(mem.rd_ports[rpidx].en[0])});
 		wr_excludes_rd_cache.insert({key, res});
 		return res;
 	}
@@ -298,14 +294,10 @@ struct MemMapping {
 		auto it = wr_excludes_srst_cache.find(key);
 		if (it != wr_excludes_srst_cache.end())
 			return it->second;
-		int wr_en = get_wr_en(wpidx);
-		int srst = qcsat.importSigBit(mem.rd_ports[rpidx].srst);
-		if (mem.rd_ports[rpidx].ce_over_srst) {
-			int rd_en = qcsat.importSigBit(mem.rd_ports[rpidx].en[0]);
-			srst = qcsat.ez->AND(srst, rd_en);
-		}
-		qcsat.prepare();
-		bool res = !qcsat.ez->solve(wr_en, srst);
+		std::vector<QuickConeSat::Term> terms = {QuickConeSat::any_of(mem.wr_ports[wpidx].en), QuickConeSat::any_of(mem.rd_ports[rpidx].srst)};
+		if (mem.rd_ports[rpidx].ce_over_srst)
+			terms.push_back(QuickConeSat::any_of(mem.rd_ports[rpidx].en[0]));
+		bool res = !qcsat.can_be_true(terms);
 		wr_excludes_srst_cache.insert({key, res});
 		return res;
 	}
@@ -323,6 +315,8 @@ struct MemMapping {
 	void handle_priority();
 	void handle_rd_rst();
 	void score_emu_ports();
+	double cost_lower_bound(const MemConfig &cfg);
+	std::vector<int> geom_key(const MemConfig &cfg);
 	void handle_geom();
 	void prune_post_geom();
 	void emit_port(const MemConfig &cfg, std::vector<Cell*> &cells, const PortVariant &pdef, const char *name, int wpidx, int rpidx, const std::vector<int> &hw_addr_swizzle);
@@ -1212,6 +1206,59 @@ void MemMapping::score_emu_ports() {
 	}
 }
 
+// The name of the resource a config uses up.  Only the cheapest config
+// per resource survives prune_post_geom.
+std::string resource_key(const Ram &ram) {
+	std::string key = ram.resource_name;
+	if (key.empty()) {
+		switch (ram.kind) {
+			case RamKind::Distributed:
+				key = "[distributed]";
+				break;
+			case RamKind::Block:
+				key = "[block]";
+				break;
+			case RamKind::Huge:
+				key = "[huge]";
+				break;
+			default:
+				break;
+		}
+	}
+	return key;
+}
+
+// A lower bound of the cost handle_geom will compute for a config: at least
+// one replica of the widest base memory per repl_port, no mux and demux
+// logic.
+double MemMapping::cost_lower_bound(const MemConfig &cfg) {
+	const Ram &ram = *cfg.def;
+	if (ram.widthscale < 0 || ram.cost < ram.widthscale)
+		return -std::numeric_limits<double>::infinity();
+	int max_width = ram.dbits.back();
+	int min_repl = std::max(1, (mem.width + max_width - 1) / max_width);
+	double cost = (ram.cost - ram.widthscale) * min_repl * cfg.repl_port;
+	cost += ram.widthscale * mem.width / max_width * cfg.repl_port;
+	cost += cfg.score_emu * FACTOR_EMU;
+	return cost;
+}
+
+// Everything about a config that the geometry picked by handle_geom depends on.
+std::vector<int> MemMapping::geom_key(const MemConfig &cfg) {
+	std::vector<int> key = {int(cfg.def - lib.rams.data()), cfg.repl_port, cfg.score_emu};
+	for (auto &pcfg: cfg.wr_ports) {
+		key.push_back(pcfg.port_group);
+		key.push_back(pcfg.port_variant);
+		key.push_back(pcfg.force_uniform);
+		key.push_back(pcfg.rd_port);
+	}
+	for (auto &pcfg: cfg.rd_ports) {
+		key.push_back(pcfg.port_group);
+		key.push_back(pcfg.port_variant);
+	}
+	return key;
+}
+
 void MemMapping::handle_geom() {
 	std::vector<int> wren_size;
 	for (auto &port: mem.wr_ports) {
@@ -1219,7 +1266,47 @@ void MemMapping::handle_geom() {
 		en.sort_and_unify();
 		wren_size.push_back(GetSize(en));
 	}
-	for (auto &cfg: cfgs) {
+	// Evaluate the configs in order of their cost lower bound, and drop
+	// those that can't beat the best config found so far for the same
+	// resource.  Configs that only differ in ways that don't matter for
+	// the geometry share the result.
+	std::vector<double> lower_bounds;
+	std::vector<int> order;
+	for (int i = 0; i < GetSize(cfgs); i++) {
+		lower_bounds.push_back(cost_lower_bound(cfgs[i]));
+		order.push_back(i);
+	}
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+		return lower_bounds[a] < lower_bounds[b];
+	});
+	dict<std::string, double> best_resource_cost;
+	dict<std::vector<int>, int> geom_cache;
+	std::vector<bool> pruned(GetSize(cfgs), false);
+	for (int cfg_idx: order) {
+		auto &cfg = cfgs[cfg_idx];
+		std::string resource = resource_key(*cfg.def);
+		auto best_it = best_resource_cost.find(resource);
+		if (best_it != best_resource_cost.end() && lower_bounds[cfg_idx] > best_it->second + 1e-6) {
+			pruned[cfg_idx] = true;
+			continue;
+		}
+		std::vector<int> key = geom_key(cfg);
+		auto cache_it = geom_cache.find(key);
+		if (cache_it != geom_cache.end()) {
+			auto &ocfg = cfgs[cache_it->second];
+			cfg.base_width_log2 = ocfg.base_width_log2;
+			cfg.unit_width_log2 = ocfg.unit_width_log2;
+			cfg.swizzle = ocfg.swizzle;
+			cfg.hard_wide_mask = ocfg.hard_wide_mask;
+			cfg.emu_wide_mask = ocfg.emu_wide_mask;
+			cfg.repl_d = ocfg.repl_d;
+			cfg.score_demux = ocfg.score_demux;
+			cfg.score_mux = ocfg.score_mux;
+			cfg.cost = ocfg.cost;
+			if (best_it == best_resource_cost.end() || cfg.cost < best_it->second)
+				best_resource_cost[resource] = cfg.cost;
+			continue;
+		}
 		// First, create a set of "byte boundaries": the bit positions in source memory word
 		// that have write enable different from the previous bit in any write port.
 		// Bit 0 is considered to be a byte boundary as well.
@@ -1519,7 +1606,16 @@ hw_bit_failed:
 bw_done:;
 		}
 		log_assert(got_config);
+		geom_cache[key] = cfg_idx;
+		if (best_it == best_resource_cost.end() || cfg.cost < best_it->second)
+			best_resource_cost[resource] = cfg.cost;
 	}
+	MemConfigs new_cfgs;
+	for (int i = 0; i < GetSize(cfgs); i++)
+		if (!pruned[i])
+			new_cfgs.push_back(cfgs[i]);
+	log_reject(stringf("Skipped %d configs that can't beat a cheaper config for the same resource.", GetSize(cfgs) - GetSize(new_cfgs)));
+	cfgs = new_cfgs;
 }
 
 void MemMapping::prune_post_geom() {
@@ -1527,22 +1623,7 @@ void MemMapping::prune_post_geom() {
 	dict<std::string, int> rsrc;
 	for (int i = 0; i < GetSize(cfgs); i++) {
 		auto &cfg = cfgs[i];
-		std::string key = cfg.def->resource_name;
-		if (key.empty()) {
-			switch (cfg.def->kind) {
-				case RamKind::Distributed:
-					key = "[distributed]";
-					break;
-				case RamKind::Block:
-					key = "[block]";
-					break;
-				case RamKind::Huge:
-					key = "[huge]";
-					break;
-				default:
-					break;
-			}
-		}
+		std::string key = resource_key(*cfg.def);
 		auto it = rsrc.find(key);
 		if (it == rsrc.end()) {
 			rsrc[key] = i;
@@ -33,6 +33,7 @@ struct MemoryMapWorker
 	bool rom_only = false;
 	bool keepdc = false;
 	bool formal = false;
+	int bmux_abits = 8;
 	dict<RTLIL::IdString, std::vector<RTLIL::Const>> attributes;
 
 	RTLIL::Design *design;
@@ -202,6 +203,7 @@ struct MemoryMapWorker
 		log("Mapping memory %s in module %s:\n", mem.memid.c_str(), module->name.c_str());
 
 		int abits = ceil_log2(mem.size);
+		bool use_bmux = abits >= bmux_abits;
 		std::vector<RTLIL::SigSpec> data_reg_in(1 << abits);
 		std::vector<RTLIL::SigSpec> data_reg_out(1 << abits);
 
@@ -291,6 +293,22 @@ struct MemoryMapWorker
 			RTLIL::SigSpec rd_addr = port.addr;
 			rd_addr.extend_u0(abits, false);
 
+			if (use_bmux)
+			{
+				// A single $bmux selecting between all (wide) words.
+				RTLIL::SigSpec rd_words;
+				for (int j = 0; j < (1 << abits); j++)
+					rd_words.append(data_read[j] != SigSpec() ? data_read[j] : RTLIL::SigSpec(State::Sx, mem.width));
+
+				if (abits > port.wide_log2) {
+					module->addBmux(genid(mem.memid, "$rdbmux", i), rd_words, rd_addr.extract_end(port.wide_log2), port.data);
+					count_mux++;
+				} else {
+					module->connect(port.data, rd_words);
+				}
+				continue;
+			}
+
 			std::vector<RTLIL::SigSpec> rd_signals;
 			rd_signals.push_back(port.data);
 
@@ -321,10 +339,34 @@ struct MemoryMapWorker
 					module->connect(RTLIL::SigSig(rd_signals[j >> port.wide_log2].extract((j & ((1 << port.wide_log2) - 1)) * mem.width, mem.width), data_read[j]));
 		}
 
-		log("  read interface: %d $dff and %d $mux cells.\n", count_dff, count_mux);
+		log("  read interface: %d $dff and %d %s cells.\n", count_dff, count_mux, use_bmux ? "$bmux" : "$mux");
 
 		if (!static_only)
 		{
+			// For each write port, a $demux decoding the address into
+			// per-word copies of the distinct enable bits.
+			std::vector<RTLIL::SigSpec> wr_sel(GetSize(mem.wr_ports));
+			std::vector<dict<RTLIL::SigBit, int>> wr_sel_idx(GetSize(mem.wr_ports));
+
+			for (int j = 0; use_bmux && j < GetSize(mem.wr_ports); j++)
+			{
+				auto &port = mem.wr_ports[j];
+				RTLIL::SigSpec wr_addr = port.addr.extract_end(port.wide_log2);
+				// Allow for the address range being shifted by start_offset.
+				if (static_ports.count(j) || GetSize(wr_addr) > abits - port.wide_log2 + 1)
+					continue;
+
+				RTLIL::SigSpec en_bits;
+				for (auto bit : port.en)
+					if (!wr_sel_idx[j].count(bit)) {
+						wr_sel_idx[j][bit] = GetSize(en_bits);
+						en_bits.append(bit);
+					}
+
+				wr_sel[j] = module->addWire(genid(mem.memid, "$wrdemux", j, "$y"), GetSize(en_bits) << GetSize(wr_addr));
+				module->addDemux(genid(mem.memid, "$wrdemux", j), en_bits, wr_addr, wr_sel[j]);
+			}
+
 			for (int i = 0; i < mem.size; i++)
 			{
 				int addr = i + mem.start_offset;
@@ -338,7 +380,12 @@ struct MemoryMapWorker
 				{
 					auto &port = mem.wr_ports[j];
 					RTLIL::SigSpec wr_addr = port.addr.extract_end(port.wide_log2);
-					RTLIL::Wire *w_seladdr = addr_decode(wr_addr, RTLIL::SigSpec(addr >> port.wide_log2, GetSize(wr_addr)));
+					RTLIL::Wire *w_seladdr = nullptr;
+					int sel_offset = 0;
+					if (wr_sel[j].empty())
+						w_seladdr = addr_decode(wr_addr, RTLIL::SigSpec(addr >> port.wide_log2, GetSize(wr_addr)));
+					else
+						sel_offset = ((addr >> port.wide_log2) & ((1 << GetSize(wr_addr)) - 1)) * GetSize(wr_sel_idx[j]);
 
 					int sub = addr & ((1 << port.wide_log2) - 1);
 
@@ -355,9 +402,13 @@ struct MemoryMapWorker
 							wr_width++;
 						}
 
-						RTLIL::Wire *w = w_seladdr;
+						RTLIL::SigSpec w = w_seladdr;
 
-						if (wr_bit != State::S1)
+						if (!wr_sel[j].empty())
+						{
+							w = wr_sel[j][sel_offset + wr_sel_idx[j].at(wr_bit[0])];
+						}
+						else if (wr_bit != State::S1)
 						{
 							RTLIL::Cell *c = module->addCell(genid(mem.memid, "$wren", addr, "", j, "", wr_offset), ID($and));
 							c->parameters[ID::A_SIGNED] = RTLIL::Const(0);
@@ -376,12 +427,12 @@ struct MemoryMapWorker
 						c->parameters[ID::WIDTH] = wr_width;
 						c->setPort(ID::A, sig.extract(wr_offset, wr_width));
 						c->setPort(ID::B, port.data.extract(wr_offset + sub * mem.width, wr_width));
-						c->setPort(ID::S, RTLIL::SigSpec(w));
+						c->setPort(ID::S, w);
 
-						w = module->addWire(genid(mem.memid, "$wrmux", addr, "", j, "", wr_offset, "$y"), wr_width);
-						c->setPort(ID::Y, w);
+						RTLIL::Wire *w_y = module->addWire(genid(mem.memid, "$wrmux", addr, "", j, "", wr_offset, "$y"), wr_width);
+						c->setPort(ID::Y, w_y);
 
-						sig.replace(wr_offset, w);
+						sig.replace(wr_offset, w_y);
 						wr_offset += wr_width;
 						count_wrmux++;
 					}
@@ -438,6 +489,12 @@ struct MemoryMapPass : public Pass {
 		log("        attributes. It also has limited support for async write ports\n");
 		log("        as generated by clk2fflogic.\n");
 		log("\n");
+		log("    -bmux-abits <N>\n");
+		log("        for memories with at least N address bits (default: 8), use a single\n");
+		log("        $bmux cell per read port and a single $demux address decoder per\n");
+		log("        write port instead of trees of $mux, $eq and $and cells. A large\n");
+		log("        value disables this.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
@@ -445,6 +502,7 @@ struct MemoryMapPass : public Pass {
 		bool rom_only = false;
 		bool keepdc = false;
 		bool formal = false;
+		int bmux_abits = 8;
 		dict<RTLIL::IdString, std::vector<RTLIL::Const>> attributes;
 
 		log_header(design, "Executing MEMORY_MAP pass (converting memories to logic and flip-flops).\n");
@@ -497,6 +555,11 @@ struct MemoryMapPass : public Pass {
 				keepdc = true;
 				continue;
 			}
+			if (args[argidx] == "-bmux-abits" && argidx + 1 < args.size())
+			{
+				bmux_abits = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -511,6 +574,7 @@ struct MemoryMapPass : public Pass {
 			worker.rom_only = rom_only;
 			worker.keepdc = keepdc;
 			worker.formal = formal;
+			worker.bmux_abits = bmux_abits;
 			worker.run();
 		}
 	}
@@ -382,10 +382,12 @@ struct MemoryShareWorker
 
 			// create SAT representation of common input cone of all considered EN signals
 
-			dict<int, int> port_to_sat_variable;
+			dict<int, SigSpec> port_to_en;
 
-			for (auto idx : group)
-				port_to_sat_variable[idx] = qcsat.ez->expression(qcsat.ez->OpOr, qcsat.importSig(mem.wr_ports[idx].en));
+			for (auto idx : group) {
+				qcsat.importSig(mem.wr_ports[idx].en);
+				port_to_en[idx] = mem.wr_ports[idx].en;
+			}
 
 			qcsat.prepare();
 
@@ -406,14 +408,14 @@ struct MemoryShareWorker
 					if (port2.removed)
 						continue;
 
-					if (qcsat.ez->solve(port_to_sat_variable.at(idx1), port_to_sat_variable.at(idx2))) {
+					if (qcsat.can_be_true({QuickConeSat::any_of(port_to_en.at(idx1)), QuickConeSat::any_of(port_to_en.at(idx2))})) {
 						log("  According to SAT solver sharing of port %d with port %d is not possible.\n", idx1, idx2);
 						continue;
 					}
 
 					log("  Merging port %d into port %d.\n", idx2, idx1);
 					mem.prepare_wr_merge(idx1, idx2, &initvals);
-					port_to_sat_variable.at(idx1) = qcsat.ez->OR(port_to_sat_variable.at(idx1), port_to_sat_variable.at(idx2));
+					port_to_en.at(idx1).append(port_to_en.at(idx2));
 
 					RTLIL::SigSpec last_addr = port1.addr;
 					RTLIL::SigSpec last_data = port1.data;
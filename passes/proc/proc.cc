@@ -108,6 +108,21 @@ struct ProcPass : public Pass {
 		}
 		extra_args(args, argidx, design);
 
+		bool has_processes = false;
+		for (auto mod : design->modules())
+			if (design->selected(mod) && mod->has_processes()) {
+				has_processes = true;
+				break;
+			}
+
+		if (!has_processes) {
+			log("No processes in selected modules, skipping the proc_* passes.\n");
+			if (!noopt)
+				Pass::call(design, "opt_expr -keepdc");
+			log_pop();
+			return;
+		}
+
 		Pass::call(design, "proc_clean");
 		if (!ifxmode)
 			Pass::call(design, "proc_rmdead");
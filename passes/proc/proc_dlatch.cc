@@ -306,6 +306,9 @@ struct proc_dlatch_db_t
 
 	void fixup_muxes()
 	{
+		if (generated_dlatches.empty())
+			return;
+
 		pool<Cell*> visited, queue;
 		dict<Cell*, pool<SigBit>> upstream_cell2net;
 		dict<SigBit, pool<Cell*>> upstream_net2cell;
@@ -465,6 +468,8 @@ struct ProcDlatchPass : public Pass {
 		extra_args(args, 1, design);
 
 		for (auto module : design->selected_modules()) {
+			if (!module->has_processes())
+				continue;
 			proc_dlatch_db_t db(module);
 			for (auto &proc_it : module->processes)
 				if (design->selected(module, proc_it.second))
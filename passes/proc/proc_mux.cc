@@ -109,6 +109,8 @@ struct SigSnippets
 struct SnippetSwCache
 {
 	dict<RTLIL::SwitchRule*, pool<RTLIL::SigBit>, hash_ptr_ops> full_case_bits_cache;
+	dict<RTLIL::SwitchRule*, std::vector<int>, hash_ptr_ops> pgroups_cache;
+	dict<RTLIL::CaseRule*, RTLIL::SigSpec, hash_ptr_ops> cmp_cache;
 	dict<RTLIL::SwitchRule*, pool<int>, hash_ptr_ops> cache;
 	const SigSnippets *snippets;
 	int current_snippet;
@@ -218,7 +220,35 @@ RTLIL::SigSpec gen_cmp(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const s
 	return RTLIL::SigSpec(ctrl_wire);
 }
 
-RTLIL::SigSpec gen_mux(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const std::vector<RTLIL::SigSpec> &compare, RTLIL::SigSpec when_signal, RTLIL::SigSpec else_signal, RTLIL::Cell *&last_mux_cell, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode)
+// The compare logic of a case only depends on the case itself, share it
+// between all signal snippets assigned in the case.
+const RTLIL::SigSpec &get_cmp(RTLIL::Module *mod, SnippetSwCache &swcache, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode)
+{
+	auto it = swcache.cmp_cache.find(cs);
+	if (it == swcache.cmp_cache.end())
+		it = swcache.cmp_cache.emplace(cs, gen_cmp(mod, sw->signal, cs->compare, sw, cs, ifxmode)).first;
+	return it->second;
+}
+
+// Select and data inputs of the last $mux/$pmux cell, collected while
+// cases are added and only written back to the cell once.
+struct PmuxBuilder
+{
+	RTLIL::Cell *cell = nullptr;
+	RTLIL::SigSpec s, b;
+
+	void flush()
+	{
+		if (cell == nullptr || GetSize(s) == 1)
+			return;
+		cell->type = ID($pmux);
+		cell->setPort(ID::S, s);
+		cell->setPort(ID::B, b);
+		cell->parameters[ID::S_WIDTH] = GetSize(s);
+	}
+};
+
+RTLIL::SigSpec gen_mux(RTLIL::Module *mod, SnippetSwCache &swcache, RTLIL::SigSpec when_signal, RTLIL::SigSpec else_signal, PmuxBuilder &last_mux, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode)
 {
 	log_assert(when_signal.size() == else_signal.size());
 
@@ -226,11 +256,11 @@ RTLIL::SigSpec gen_mux(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const s
 	sstr << "$procmux$" << (autoidx++);
 
 	// the trivial cases
-	if (compare.size() == 0 || when_signal == else_signal)
+	if (cs->compare.size() == 0 || when_signal == else_signal)
 		return when_signal;
 
 	// compare results
-	RTLIL::SigSpec ctrl_sig = gen_cmp(mod, signal, compare, sw, cs, ifxmode);
+	RTLIL::SigSpec ctrl_sig = get_cmp(mod, swcache, sw, cs, ifxmode);
 	if (ctrl_sig.size() == 0)
 		return when_signal;
 	log_assert(ctrl_sig.size() == 1);
@@ -248,31 +278,87 @@ RTLIL::SigSpec gen_mux(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const s
 	mux_cell->setPort(ID::S, ctrl_sig);
 	mux_cell->setPort(ID::Y, RTLIL::SigSpec(result_wire));
 
-	last_mux_cell = mux_cell;
+	last_mux.flush();
+	last_mux.cell = mux_cell;
+	last_mux.s = ctrl_sig;
+	last_mux.b = when_signal;
 	return RTLIL::SigSpec(result_wire);
 }
 
-void append_pmux(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const std::vector<RTLIL::SigSpec> &compare, RTLIL::SigSpec when_signal, RTLIL::Cell *last_mux_cell, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode)
+void append_pmux(RTLIL::Module *mod, SnippetSwCache &swcache, RTLIL::SigSpec when_signal, PmuxBuilder &last_mux, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode)
 {
-	log_assert(last_mux_cell != NULL);
-	log_assert(when_signal.size() == last_mux_cell->getPort(ID::A).size());
+	log_assert(last_mux.cell != NULL);
+	log_assert(when_signal.size() == last_mux.cell->getPort(ID::A).size());
 
-	if (when_signal == last_mux_cell->getPort(ID::A))
+	if (when_signal == last_mux.cell->getPort(ID::A))
 		return;
 
-	RTLIL::SigSpec ctrl_sig = gen_cmp(mod, signal, compare, sw, cs, ifxmode);
+	RTLIL::SigSpec ctrl_sig = get_cmp(mod, swcache, sw, cs, ifxmode);
 	log_assert(ctrl_sig.size() == 1);
-	last_mux_cell->type = ID($pmux);
 
-	RTLIL::SigSpec new_s = last_mux_cell->getPort(ID::S);
-	new_s.append(ctrl_sig);
-	last_mux_cell->setPort(ID::S, new_s);
+	last_mux.s.append(ctrl_sig);
+	last_mux.b.append(when_signal);
+}
+
+// Groups of consecutive cases that can be merged into a single $pmux.
+// These only depend on the switch, so they are computed once and shared
+// between all signal snippets.
+const std::vector<int> &get_pgroups(SnippetSwCache &swcache, RTLIL::SwitchRule *sw, bool ifxmode)
+{
+	auto it = swcache.pgroups_cache.find(sw);
+	if (it != swcache.pgroups_cache.end())
+		return it->second;
 
-	RTLIL::SigSpec new_b = last_mux_cell->getPort(ID::B);
-	new_b.append(when_signal);
-	last_mux_cell->setPort(ID::B, new_b);
+	// detect groups of parallel cases
+	std::vector<int> pgroups(sw->cases.size());
+	bool is_simple_parallel_case = true;
 
-	last_mux_cell->parameters[ID::S_WIDTH] = last_mux_cell->getPort(ID::S).size();
+	if (!sw->get_bool_attribute(ID::parallel_case)) {
+		pool<Const> case_values;
+		for (size_t i = 0; i < sw->cases.size(); i++) {
+			RTLIL::CaseRule *cs2 = sw->cases[i];
+			for (auto pat : cs2->compare) {
+				if (!pat.is_fully_def())
+					goto not_simple_parallel_case;
+				Const cpat = pat.as_const();
+				if (case_values.count(cpat))
+					goto not_simple_parallel_case;
+				case_values.insert(cpat);
+			}
+		}
+		if (0)
+	not_simple_parallel_case:
+			is_simple_parallel_case = false;
+	}
+
+	if (!is_simple_parallel_case) {
+		BitPatternPool pool(sw->signal.size());
+		bool extra_group_for_next_case = false;
+		for (size_t i = 0; i < sw->cases.size(); i++) {
+			RTLIL::CaseRule *cs2 = sw->cases[i];
+			if (i != 0) {
+				pgroups[i] = pgroups[i-1];
+				if (extra_group_for_next_case) {
+					pgroups[i] = pgroups[i-1]+1;
+					extra_group_for_next_case = false;
+				}
+				for (auto pat : cs2->compare)
+					if (!pat.is_fully_const() || !pool.has_all(pat))
+						pgroups[i] = pgroups[i-1]+1;
+				if (cs2->compare.empty())
+					pgroups[i] = pgroups[i-1]+1;
+				if (pgroups[i] != pgroups[i-1])
+					pool = BitPatternPool(sw->signal.size());
+			}
+			for (auto pat : cs2->compare)
+				if (!pat.is_fully_const())
+					extra_group_for_next_case = true;
+				else if (!ifxmode)
+					pool.take(pat);
+		}
+	}
+
+	return swcache.pgroups_cache[sw] = std::move(pgroups);
 }
 
 const pool<SigBit> &get_full_case_bits(SnippetSwCache &swcache, RTLIL::SwitchRule *sw)
@@ -318,8 +404,7 @@ const pool<SigBit> &get_full_case_bits(SnippetSwCache &swcache, RTLIL::SwitchRul
 	return swcache.full_case_bits_cache.at(sw);
 }
 
-RTLIL::SigSpec signal_to_mux_tree(RTLIL::Module *mod, SnippetSwCache &swcache, dict<RTLIL::SwitchRule*, bool, hash_ptr_ops> &swpara,
-		RTLIL::CaseRule *cs, const RTLIL::SigSpec &sig, const RTLIL::SigSpec &defval, bool ifxmode)
+RTLIL::SigSpec signal_to_mux_tree(RTLIL::Module *mod, SnippetSwCache &swcache, RTLIL::CaseRule *cs, const RTLIL::SigSpec &sig, const RTLIL::SigSpec &defval, bool ifxmode)
 {
 	RTLIL::SigSpec result = defval;
 
@@ -333,59 +418,9 @@ RTLIL::SigSpec signal_to_mux_tree(RTLIL::Module *mod, SnippetSwCache &swcache, d
 		if (!swcache.check(sw))
 			continue;
 
-		// detect groups of parallel cases
-		std::vector<int> pgroups(sw->cases.size());
-		bool is_simple_parallel_case = true;
-
-		if (!sw->get_bool_attribute(ID::parallel_case)) {
-			if (!swpara.count(sw)) {
-				pool<Const> case_values;
-				for (size_t i = 0; i < sw->cases.size(); i++) {
-					RTLIL::CaseRule *cs2 = sw->cases[i];
-					for (auto pat : cs2->compare) {
-						if (!pat.is_fully_def())
-							goto not_simple_parallel_case;
-						Const cpat = pat.as_const();
-						if (case_values.count(cpat))
-							goto not_simple_parallel_case;
-						case_values.insert(cpat);
-					}
-				}
-				if (0)
-			not_simple_parallel_case:
-					is_simple_parallel_case = false;
-				swpara[sw] = is_simple_parallel_case;
-			} else {
-				is_simple_parallel_case = swpara.at(sw);
-			}
-		}
-
-		if (!is_simple_parallel_case) {
-			BitPatternPool pool(sw->signal.size());
-			bool extra_group_for_next_case = false;
-			for (size_t i = 0; i < sw->cases.size(); i++) {
-				RTLIL::CaseRule *cs2 = sw->cases[i];
-				if (i != 0) {
-					pgroups[i] = pgroups[i-1];
-					if (extra_group_for_next_case) {
-						pgroups[i] = pgroups[i-1]+1;
-						extra_group_for_next_case = false;
-					}
-					for (auto pat : cs2->compare)
-						if (!pat.is_fully_const() || !pool.has_all(pat))
-							pgroups[i] = pgroups[i-1]+1;
-					if (cs2->compare.empty())
-						pgroups[i] = pgroups[i-1]+1;
-					if (pgroups[i] != pgroups[i-1])
-						pool = BitPatternPool(sw->signal.size());
-				}
-				for (auto pat : cs2->compare)
-					if (!pat.is_fully_const())
-						extra_group_for_next_case = true;
-					else if (!ifxmode)
-						pool.take(pat);
-			}
-		}
+		// Copied, the recursion below adds entries for nested switches to
+		// the cache and may move the stored vectors.
+		std::vector<int> pgroups = get_pgroups(swcache, sw, ifxmode);
 
 		// mask default bits that are irrelevant because the output is driven by a full case
 		const pool<SigBit> &full_case_bits = get_full_case_bits(swcache, sw);
@@ -395,16 +430,17 @@ RTLIL::SigSpec signal_to_mux_tree(RTLIL::Module *mod, SnippetSwCache &swcache, d
 
 		// evaluate in reverse order to give the first entry the top priority
 		RTLIL::SigSpec initial_val = result;
-		RTLIL::Cell *last_mux_cell = NULL;
+		PmuxBuilder last_mux;
 		for (size_t i = 0; i < sw->cases.size(); i++) {
 			int case_idx = sw->cases.size() - i - 1;
 			RTLIL::CaseRule *cs2 = sw->cases[case_idx];
-			RTLIL::SigSpec value = signal_to_mux_tree(mod, swcache, swpara, cs2, sig, initial_val, ifxmode);
-			if (last_mux_cell && pgroups[case_idx] == pgroups[case_idx+1])
-				append_pmux(mod, sw->signal, cs2->compare, value, last_mux_cell, sw, cs2, ifxmode);
+			RTLIL::SigSpec value = signal_to_mux_tree(mod, swcache, cs2, sig, initial_val, ifxmode);
+			if (last_mux.cell && pgroups[case_idx] == pgroups[case_idx+1])
+				append_pmux(mod, swcache, value, last_mux, sw, cs2, ifxmode);
 			else
-				result = gen_mux(mod, sw->signal, cs2->compare, value, result, last_mux_cell, sw, cs2, ifxmode);
+				result = gen_mux(mod, swcache, value, result, last_mux, sw, cs2, ifxmode);
 		}
+		last_mux.flush();
 	}
 
 	return result;
@@ -421,8 +457,6 @@ void proc_mux(RTLIL::Module *mod, RTLIL::Process *proc, bool ifxmode)
 	swcache.snippets = &sigsnip;
 	swcache.insert(&proc->root_case);
 
-	dict<RTLIL::SwitchRule*, bool, hash_ptr_ops> swpara;
-
 	int cnt = 0;
 	for (int idx : sigsnip.snippets)
 	{
@@ -431,7 +465,7 @@ void proc_mux(RTLIL::Module *mod, RTLIL::Process *proc, bool ifxmode)
 
 		log("%6d/%d: %s\n", ++cnt, GetSize(sigsnip.snippets), log_signal(sig));
 
-		RTLIL::SigSpec value = signal_to_mux_tree(mod, swcache, swpara, &proc->root_case, sig, RTLIL::SigSpec(RTLIL::State::Sx, sig.size()), ifxmode);
+		RTLIL::SigSpec value = signal_to_mux_tree(mod, swcache, &proc->root_case, sig, RTLIL::SigSpec(RTLIL::State::Sx, sig.size()), ifxmode);
 		mod->connect(RTLIL::SigSig(sig, value));
 	}
 }
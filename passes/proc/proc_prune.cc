@@ -128,7 +128,7 @@ struct ProcPrunePass : public Pass {
 		extra_args(args, 1, design);
 
 		for (auto mod : design->modules()) {
-			if (!design->selected(mod))
+			if (!design->selected(mod) || !mod->has_processes())
 				continue;
 			PruneWorker worker(mod);
 			for (auto &proc_it : mod->processes) {
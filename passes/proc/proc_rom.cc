@@ -244,7 +244,7 @@ struct ProcRomPass : public Pass {
 		extra_args(args, 1, design);
 
 		for (auto mod : design->modules()) {
-			if (!design->selected(mod))
+			if (!design->selected(mod) || !mod->has_processes())
 				continue;
 			RomWorker worker(mod);
 			for (auto &proc_it : mod->processes) {
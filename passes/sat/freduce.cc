@@ -241,6 +241,18 @@ struct PerformReduction
 	std::vector<int> out_depth;
 	int cone_size;
 
+	// The cone is simulated with 64 input vectors at a time. Signals with
+	// different simulation signatures can't be equivalent, so buckets are
+	// split by signature before the SAT solver is asked. The input vectors
+	// of SAT models that split a bucket are collected and simulated as well.
+	std::vector<RTLIL::Cell*> sim_cells;
+	pool<RTLIL::Cell*> sim_cells_done;
+	dict<RTLIL::SigBit, int> sim_index;
+	std::vector<std::vector<uint64_t>> out_sigs;
+	std::vector<bool> out_sim_undef;
+	std::vector<std::vector<bool>> sat_models;
+	uint64_t sim_rng_state = 88172645463325252ULL;
+
 	int register_cone_worker(std::set<RTLIL::Cell*> &celldone, std::map<RTLIL::SigBit, int> &sigdepth, RTLIL::SigBit out)
 	{
 		if (out.wire == NULL)
@@ -268,7 +280,16 @@ struct PerformReduction
 			for (auto &bit : drv.second)
 				max_child_depth = max(register_cone_worker(celldone, sigdepth, bit), max_child_depth);
 			sigdepth[out] = max_child_depth + 1;
+			if (sim_cells_done.insert(drv.first).second) {
+				sim_cells.push_back(drv.first);
+				for (auto &conn : drv.first->connections())
+					if (yosys_celltypes.cell_output(drv.first->type, conn.first))
+						for (auto bit : sigmap(conn.second))
+							if (bit.wire != NULL && !sim_index.count(bit))
+								sim_index[bit] = GetSize(sim_index);
+			}
 		} else {
+			sim_index[out] = GetSize(sim_index);
 			pi_bits.push_back(out);
 			sat_pi.push_back(satgen.importSigSpec(out).front());
 			ez->assume(ez->NOT(satgen.importUndefSigSpec(out).front()));
@@ -301,6 +322,195 @@ struct PerformReduction
 					sat_out[i] = ez->NOT(sat_out[i]);
 		} else
 			out_inverted = std::vector<bool>(sat_out.size(), false);
+
+		out_sigs.resize(GetSize(out_bits));
+		out_sim_undef.resize(GetSize(out_bits));
+		if (cone_size > 0) {
+			std::vector<uint64_t> pi_words;
+			for (int i = 0; i < GetSize(pi_bits); i++)
+				pi_words.push_back(sim_random());
+			simulate(pi_words, 64);
+		}
+	}
+
+	uint64_t sim_random()
+	{
+		sim_rng_state ^= sim_rng_state << 13;
+		sim_rng_state ^= sim_rng_state >> 7;
+		sim_rng_state ^= sim_rng_state << 17;
+		return sim_rng_state;
+	}
+
+	void sim_get(RTLIL::SigBit bit, const std::vector<uint64_t> &val, const std::vector<uint64_t> &def, uint64_t &v, uint64_t &d)
+	{
+		if (bit.wire == NULL) {
+			v = bit.data == RTLIL::State::S1 ? ~uint64_t(0) : 0;
+			d = bit.data == RTLIL::State::S0 || bit.data == RTLIL::State::S1 ? ~uint64_t(0) : 0;
+		} else {
+			int idx = sim_index.at(bit);
+			v = val[idx], d = def[idx];
+		}
+	}
+
+	void simulate(const std::vector<uint64_t> &pi_words, int num_lanes)
+	{
+		uint64_t lanes = num_lanes == 64 ? ~uint64_t(0) : (uint64_t(1) << num_lanes) - 1;
+		std::vector<uint64_t> val(GetSize(sim_index)), def(GetSize(sim_index));
+
+		for (int i = 0; i < GetSize(pi_bits); i++) {
+			int idx = sim_index.at(pi_bits[i]);
+			val[idx] = pi_words[i];
+			def[idx] = ~uint64_t(0);
+		}
+
+		for (auto cell : sim_cells)
+		{
+			if (!cell->hasPort(ID::Y))
+				continue;
+
+			RTLIL::SigSpec sig_y = sigmap(cell->getPort(ID::Y));
+
+			if (cell->type.in(ID($_BUF_), ID($_NOT_), ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_), ID($_XOR_), ID($_XNOR_),
+					ID($_ANDNOT_), ID($_ORNOT_), ID($_MUX_), ID($_NMUX_), ID($_AOI3_), ID($_OAI3_), ID($_AOI4_), ID($_OAI4_)))
+			{
+				uint64_t a = 0, b = 0, c = 0, d = 0, s = 0, y = 0;
+				uint64_t a_def = ~uint64_t(0), b_def = ~uint64_t(0), c_def = ~uint64_t(0), d_def = ~uint64_t(0), s_def = ~uint64_t(0);
+
+				sim_get(sigmap(cell->getPort(ID::A)), val, def, a, a_def);
+				if (cell->hasPort(ID::B))
+					sim_get(sigmap(cell->getPort(ID::B)), val, def, b, b_def);
+				if (cell->hasPort(ID::C))
+					sim_get(sigmap(cell->getPort(ID::C)), val, def, c, c_def);
+				if (cell->hasPort(ID::D))
+					sim_get(sigmap(cell->getPort(ID::D)), val, def, d, d_def);
+				if (cell->hasPort(ID::S))
+					sim_get(sigmap(cell->getPort(ID::S)), val, def, s, s_def);
+
+				if (cell->type == ID($_BUF_)) y = a;
+				if (cell->type == ID($_NOT_)) y = ~a;
+				if (cell->type == ID($_AND_)) y = a & b;
+				if (cell->type == ID($_NAND_)) y = ~(a & b);
+				if (cell->type == ID($_OR_)) y = a | b;
+				if (cell->type == ID($_NOR_)) y = ~(a | b);
+				if (cell->type == ID($_XOR_)) y = a ^ b;
+				if (cell->type == ID($_XNOR_)) y = ~(a ^ b);
+				if (cell->type == ID($_ANDNOT_)) y = a & ~b;
+				if (cell->type == ID($_ORNOT_)) y = a | ~b;
+				if (cell->type == ID($_MUX_)) y = (a & ~s) | (b & s);
+				if (cell->type == ID($_NMUX_)) y = ~((a & ~s) | (b & s));
+				if (cell->type == ID($_AOI3_)) y = ~((a & b) | c);
+				if (cell->type == ID($_OAI3_)) y = ~((a | b) & c);
+				if (cell->type == ID($_AOI4_)) y = ~((a & b) | (c & d));
+				if (cell->type == ID($_OAI4_)) y = ~((a | b) & (c | d));
+
+				// lanes with an undefined input are treated as undefined
+				if (sig_y[0].wire != NULL) {
+					int idx = sim_index.at(sig_y[0]);
+					val[idx] = y;
+					def[idx] = a_def & b_def & c_def & d_def & s_def;
+				}
+				continue;
+			}
+
+			if (!yosys_celltypes.cell_evaluable(cell->type))
+				continue;
+
+			bool supported = true;
+			for (auto &conn : cell->connections())
+				if (!conn.first.in(ID::A, ID::B, ID::S, ID::Y))
+					supported = false;
+			if (!supported)
+				continue;
+
+			// evaluate all other cells one input vector at a time
+			RTLIL::SigSpec sig_a = cell->hasPort(ID::A) ? sigmap(cell->getPort(ID::A)) : RTLIL::SigSpec();
+			RTLIL::SigSpec sig_b = cell->hasPort(ID::B) ? sigmap(cell->getPort(ID::B)) : RTLIL::SigSpec();
+			RTLIL::SigSpec sig_s = cell->hasPort(ID::S) ? sigmap(cell->getPort(ID::S)) : RTLIL::SigSpec();
+
+			for (int lane = 0; lane < num_lanes; lane++)
+			{
+				bool lane_def = true;
+				auto lane_value = [&](const RTLIL::SigSpec &sig) {
+					RTLIL::Const value(RTLIL::State::S0, GetSize(sig));
+					for (int i = 0; i < GetSize(sig); i++) {
+						uint64_t v, d;
+						sim_get(sig[i], val, def, v, d);
+						if (((d >> lane) & 1) == 0)
+							lane_def = false;
+						if ((v >> lane) & 1)
+							value.bits[i] = RTLIL::State::S1;
+					}
+					return value;
+				};
+
+				RTLIL::Const a = lane_value(sig_a), b = lane_value(sig_b), s = lane_value(sig_s);
+				if (!lane_def)
+					continue;
+
+				bool err = false;
+				RTLIL::Const y = cell->hasPort(ID::S) ? CellTypes::eval(cell, a, b, s, &err) : CellTypes::eval(cell, a, b, &err);
+				if (err || GetSize(y) != GetSize(sig_y))
+					break;
+
+				for (int i = 0; i < GetSize(sig_y); i++) {
+					if (sig_y[i].wire == NULL || (y[i] != RTLIL::State::S0 && y[i] != RTLIL::State::S1))
+						continue;
+					int idx = sim_index.at(sig_y[i]);
+					def[idx] |= uint64_t(1) << lane;
+					if (y[i] == RTLIL::State::S1)
+						val[idx] |= uint64_t(1) << lane;
+				}
+			}
+		}
+
+		for (int i = 0; i < GetSize(out_bits); i++) {
+			uint64_t v, d;
+			sim_get(out_bits[i], val, def, v, d);
+			if ((d & lanes) != lanes)
+				out_sim_undef[i] = true;
+			out_sigs[i].push_back((out_inverted[i] ? ~v : v) & lanes);
+		}
+	}
+
+	void add_sat_model(const std::vector<bool> &model)
+	{
+		sat_models.push_back(std::vector<bool>(model.end() - GetSize(sat_pi), model.end()));
+		if (GetSize(sat_models) < 64)
+			return;
+
+		std::vector<uint64_t> pi_words(GetSize(pi_bits));
+		for (int lane = 0; lane < 64; lane++)
+			for (int i = 0; i < GetSize(pi_bits); i++)
+				if (sat_models[lane][i])
+					pi_words[i] |= uint64_t(1) << lane;
+		simulate(pi_words, 64);
+		sat_models.clear();
+	}
+
+	bool sim_split(std::vector<std::set<int>> &results, std::map<int, int> &results_map, std::vector<int> &bucket, std::string indent1, std::string indent2)
+	{
+		std::map<std::vector<uint64_t>, std::vector<int>> parts;
+		std::vector<int> undef_signals;
+
+		for (int idx : bucket)
+			if (out_sim_undef[idx])
+				undef_signals.push_back(idx);
+			else
+				parts[out_sigs[idx]].push_back(idx);
+
+		// signals that are undefined in some simulation lane go into every
+		// part, which only pays off if there are not too many of them
+		if (GetSize(parts) <= 1 || 4 * GetSize(undef_signals) > GetSize(bucket))
+			return false;
+
+		if (verbose_level >= 1)
+			log("%s  Simulation splits bucket with %d signals into %d parts.\n", (indent1 + indent2).c_str(), int(bucket.size()), GetSize(parts));
+
+		for (auto &it : parts) {
+			it.second.insert(it.second.end(), undef_signals.begin(), undef_signals.end());
+			analyze(results, results_map, it.second, indent1 + "s", indent2 + "  ");
+		}
+		return true;
 	}
 
 	void analyze_const(std::vector<std::vector<equiv_bit_t>> &results, int idx)
@@ -355,6 +565,9 @@ struct PerformReduction
 		if (bucket.size() <= 1)
 			return;
 
+		if (sim_split(results, results_map, bucket, indent1, indent2))
+			return;
+
 		if (verbose_level == 1)
 			log("%s  Trying to shatter bucket with %d signals.\n", indt, int(bucket.size()));
 
@@ -375,8 +588,7 @@ struct PerformReduction
 		std::vector<bool> model;
 
 		modelVars.insert(modelVars.end(), sat_def.begin(), sat_def.end());
-		if (verbose_level >= 2)
-			modelVars.insert(modelVars.end(), sat_pi.begin(), sat_pi.end());
+		modelVars.insert(modelVars.end(), sat_pi.begin(), sat_pi.end());
 
 		if (ez->solve(modelVars, model, ez->expression(ezSAT::OpOr, sat_set_list), ez->expression(ezSAT::OpOr, sat_clr_list)))
 		{
@@ -402,6 +614,8 @@ struct PerformReduction
 				iter_count++;
 			}
 
+			add_sat_model(model);
+
 			if (verbose_level >= 1) {
 				int count_set = 0, count_clr = 0, count_undef = 0;
 				for (int idx : bucket)
@@ -788,6 +1002,10 @@ struct FreducePass : public Pass {
 		log("This pass is undef-aware, i.e. it considers don't-care values for detecting\n");
 		log("equivalent nodes.\n");
 		log("\n");
+		log("Candidate nodes are first simulated with random input vectors and with the\n");
+		log("inputs of earlier SAT models. Only nodes that agree in simulation are checked\n");
+		log("with the SAT solver.\n");
+		log("\n");
 		log("All selected wires are considered for rewiring. The selected cells cover the\n");
 		log("circuit that is analyzed.\n");
 		log("\n");
@@ -27,6 +27,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include "kernel/satgen.h"
+#include "kernel/cellaigs.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <algorithm>
@@ -65,6 +66,12 @@ struct SatHelper
 	int max_timestep, timeout;
 	bool gotTimeout;
 
+	// when non-zero, initial state constraints only hold under this literal
+	int init_context;
+
+	// shared AIG for the combinational cells, see -strash
+	std::unique_ptr<ModuleAig> aig;
+
 	SatHelper(RTLIL::Design *design, RTLIL::Module *module, bool enable_undef, bool set_def_formal) :
 		design(design), module(module), sigmap(module), ct(design), satgen(ez.get(), &sigmap)
 	{
@@ -78,6 +85,31 @@ struct SatHelper
 		max_timestep = -1;
 		timeout = 0;
 		gotTimeout = false;
+		init_context = 0;
+	}
+
+	void enable_strash()
+	{
+		if (enable_undef) {
+			log("Not using a shared AIG because undef modeling is enabled.\n");
+			return;
+		}
+
+		aig.reset(new ModuleAig(&sigmap));
+		int aig_cells = 0;
+		for (auto cell : module->selected_cells())
+			if (aig->add_cell(cell))
+				aig_cells++;
+		satgen.aig = aig.get();
+		log("Using a shared AIG for %d cells.\n", aig_cells);
+	}
+
+	void assume_init(int id)
+	{
+		if (init_context)
+			ez->assume(id, init_context);
+		else
+			ez->assume(id);
 	}
 
 	void check_undef_enabled(const RTLIL::SigSpec &sig)
@@ -324,7 +356,7 @@ struct SatHelper
 			if (set_init_def) {
 				RTLIL::SigSpec rem = satgen.initial_state.export_all();
 				std::vector<int> undef_rem = satgen.importUndefSigSpec(rem, 1);
-				ez->assume(ez->NOT(ez->expression(ezSAT::OpOr, undef_rem)));
+				assume_init(ez->NOT(ez->expression(ezSAT::OpOr, undef_rem)));
 			}
 
 			if (set_init_undef) {
@@ -349,7 +381,7 @@ struct SatHelper
 
 			log("Final init constraint equation: %s = %s\n", log_signal(big_lhs), log_signal(big_rhs));
 			check_undef_enabled(big_lhs), check_undef_enabled(big_rhs);
-			ez->assume(satgen.signals_eq(big_lhs, big_rhs, timestep));
+			assume_init(satgen.signals_eq(big_lhs, big_rhs, timestep));
 		}
 	}
 
@@ -434,11 +466,16 @@ struct SatHelper
 		return ez->expression(ezSAT::OpAnd, prove_bits);
 	}
 
-	void force_unique_state(int timestep_from, int timestep_to)
+	void force_unique_state(int timestep_from, int timestep_to, int context = 0)
 	{
 		RTLIL::SigSpec state_signals = satgen.initial_state.export_all();
-		for (int i = timestep_from; i < timestep_to; i++)
-			ez->assume(ez->NOT(satgen.signals_eq(state_signals, state_signals, i, timestep_to)));
+		for (int i = timestep_from; i < timestep_to; i++) {
+			int unique = ez->NOT(satgen.signals_eq(state_signals, state_signals, i, timestep_to));
+			if (context)
+				ez->assume(unique, context);
+			else
+				ez->assume(unique);
+		}
 	}
 
 	bool solve(const std::vector<int> &assumptions)
@@ -960,6 +997,11 @@ struct SatPass : public Pass {
 		log("    -ignore_unknown_cells\n");
 		log("        ignore all cells that can not be matched to a SAT model\n");
 		log("\n");
+		log("    -strash\n");
+		log("        import combinational cells from a structurally hashed AIG of the\n");
+		log("        selected cells, so that logic shared between cells is encoded only\n");
+		log("        once. this option has no effect when undef modeling is enabled.\n");
+		log("\n");
 		log("The following options can be used to set up a sequential problem:\n");
 		log("\n");
 		log("    -seq <N>\n");
@@ -1012,6 +1054,10 @@ struct SatPass : public Pass {
 		log("        proven that the condition holds forever after the number of time steps\n");
 		log("        specified using -seq.\n");
 		log("\n");
+		log("        If no -seq, -set-at or similar per-timestep options are used, the\n");
+		log("        base case and the induction step are solved incrementally on one\n");
+		log("        shared unrolling of the circuit.\n");
+		log("\n");
 		log("    -tempinduct-def\n");
 		log("        Perform a temporal induction proof. Assume an initial state with all\n");
 		log("        registers set to defined values for the induction step.\n");
@@ -1080,7 +1126,7 @@ struct SatPass : public Pass {
 		std::vector<std::string> shows, sets_def, sets_any_undef, sets_all_undef;
 		int loopcount = 0, seq_len = 0, maxsteps = 0, initsteps = 0, timeout = 0, prove_skip = 0;
 		bool verify = false, fail_on_timeout = false, enable_undef = false, set_def_inputs = false, set_def_formal = false;
-		bool ignore_div_by_zero = false, set_init_undef = false, set_init_zero = false, max_undef = false;
+		bool ignore_div_by_zero = false, strash = false, set_init_undef = false, set_init_zero = false, max_undef = false;
 		bool tempinduct = false, prove_asserts = false, show_inputs = false, show_outputs = false;
 		bool show_regs = false, show_public = false, show_all = false;
 		bool ignore_unknown_cells = false, falsify = false, tempinduct_def = false, set_init_def = false;
@@ -1134,6 +1180,10 @@ struct SatPass : public Pass {
 				stepsize = max(1, atoi(args[++argidx].c_str()));
 				continue;
 			}
+			if (args[argidx] == "-strash") {
+				strash = true;
+				continue;
+			}
 			if (args[argidx] == "-ignore_div_by_zero") {
 				ignore_div_by_zero = true;
 				continue;
@@ -1399,6 +1449,25 @@ struct SatPass : public Pass {
 			SatHelper basecase(design, module, enable_undef, set_def_formal);
 			SatHelper inductstep(design, module, enable_undef, set_def_formal);
 
+			// Without an initial sequence or per-timestep constraints the base case
+			// and the induction step unroll the same time frames, so both can be
+			// solved incrementally on a single unrolling. The initial state
+			// constraints are then only enabled for the base case.
+			bool shared_unroll = seq_len == 0 && !tempinduct_baseonly && !tempinduct_inductonly &&
+					!tempinduct_def && cnf_file_name.empty() && sets_at.empty() && unsets_at.empty() &&
+					sets_def_at.empty() && sets_any_undef_at.empty() && sets_all_undef_at.empty();
+			for (auto cell : module->cells())
+				if (cell->type == ID($initstate))
+					shared_unroll = false;
+
+			SatHelper &induct = shared_unroll ? basecase : inductstep;
+			int next_property = 0;
+
+			if (shared_unroll) {
+				log("\nUsing a single unrolling for base case and induction step.\n");
+				basecase.init_context = basecase.ez->frozen_literal();
+			}
+
 			basecase.sets = sets;
 			basecase.set_assumes = set_assumes;
 			basecase.prove = prove;
@@ -1420,6 +1489,8 @@ struct SatPass : public Pass {
 			basecase.set_init_zero = set_init_zero;
 			basecase.satgen.ignore_div_by_zero = ignore_div_by_zero;
 			basecase.ignore_unknown_cells = ignore_unknown_cells;
+			if (strash)
+				basecase.enable_strash();
 
 			for (int timestep = 1; timestep <= seq_len; timestep++)
 				if (!tempinduct_inductonly)
@@ -1437,8 +1508,10 @@ struct SatPass : public Pass {
 			inductstep.sets_all_undef = sets_all_undef;
 			inductstep.satgen.ignore_div_by_zero = ignore_div_by_zero;
 			inductstep.ignore_unknown_cells = ignore_unknown_cells;
+			if (strash)
+				inductstep.enable_strash();
 
-			if (!tempinduct_baseonly) {
+			if (!tempinduct_baseonly && !shared_unroll) {
 				inductstep.setup(1);
 				inductstep.ez->assume(inductstep.setup_proof(1));
 			}
@@ -1456,12 +1529,15 @@ struct SatPass : public Pass {
 
 				if (!tempinduct_inductonly)
 				{
-					basecase.setup(seq_len + inductlen, seq_len + inductlen == 1);
-					int property = basecase.setup_proof(seq_len + inductlen);
+					int property = next_property;
+					if (property == 0) {
+						basecase.setup(seq_len + inductlen, seq_len + inductlen == 1);
+						property = basecase.setup_proof(seq_len + inductlen);
+					}
 					basecase.generate_model();
 
 					if (inductlen > 1)
-						basecase.force_unique_state(seq_len + 1, seq_len + inductlen);
+						basecase.force_unique_state(seq_len + 1, seq_len + inductlen, basecase.init_context);
 
 					if (tempinduct_skip < inductlen)
 					{
@@ -1469,7 +1545,7 @@ struct SatPass : public Pass {
 								inductlen, basecase.ez->numCnfVariables(), basecase.ez->numCnfClauses());
 						log_flush();
 
-						if (basecase.solve(basecase.ez->NOT(property))) {
+						if (basecase.solve(basecase.ez->NOT(property), basecase.init_context)) {
 							log("SAT temporal induction proof finished - model found for base case: FAIL!\n");
 							print_proof_failed();
 							basecase.print_model();
@@ -1499,12 +1575,17 @@ struct SatPass : public Pass {
 
 				if (!tempinduct_baseonly)
 				{
-					inductstep.setup(inductlen + 1);
-					int property = inductstep.setup_proof(inductlen + 1);
-					inductstep.generate_model();
+					induct.setup(inductlen + 1);
+					int property = induct.setup_proof(inductlen + 1);
+					induct.generate_model();
+
+					// the base case of the next iteration proves the property for
+					// this time frame and adds it to the shared unrolling
+					if (shared_unroll)
+						next_property = property;
 
 					if (inductlen > 1)
-						inductstep.force_unique_state(1, inductlen + 1);
+						induct.force_unique_state(1, inductlen + 1);
 
 					if (inductlen <= tempinduct_skip || inductlen <= initsteps || inductlen % stepsize != 0)
 					{
@@ -1518,8 +1599,9 @@ struct SatPass : public Pass {
 							log("\n[induction step %d] Skipping prove for this step (-stepsize %d).",
 									inductlen, stepsize);
 						log("\n[induction step %d] Problem size so far: %d variables and %d clauses.\n",
-								inductlen, inductstep.ez->numCnfVariables(), inductstep.ez->numCnfClauses());
-						inductstep.ez->assume(property);
+								inductlen, induct.ez->numCnfVariables(), induct.ez->numCnfClauses());
+						if (!shared_unroll)
+							induct.ez->assume(property);
 					}
 					else
 					{
@@ -1533,16 +1615,16 @@ struct SatPass : public Pass {
 							log("Dumping CNF to file `%s'.\n", cnf_file_name.c_str());
 							cnf_file_name.clear();
 
-							inductstep.ez->printDIMACS(f, false);
+							induct.ez->printDIMACS(f, false);
 							fclose(f);
 						}
 
 						log("\n[induction step %d] Solving problem with %d variables and %d clauses..\n",
-								inductlen, inductstep.ez->numCnfVariables(), inductstep.ez->numCnfClauses());
+								inductlen, induct.ez->numCnfVariables(), induct.ez->numCnfClauses());
 						log_flush();
 
-						if (!inductstep.solve(inductstep.ez->NOT(property))) {
-							if (inductstep.gotTimeout)
+						if (!induct.solve(induct.ez->NOT(property))) {
+							if (induct.gotTimeout)
 								goto timeout;
 							log("Induction step proven: SUCCESS!\n");
 							print_qed();
@@ -1550,8 +1632,9 @@ struct SatPass : public Pass {
 						}
 
 						log("Induction step failed. Incrementing induction length.\n");
-						inductstep.ez->assume(property);
-						inductstep.print_model();
+						if (!shared_unroll)
+							induct.ez->assume(property);
+						induct.print_model();
 					}
 				}
 			}
@@ -1563,9 +1646,9 @@ struct SatPass : public Pass {
 
 			log("\nReached maximum number of time steps -> proof failed.\n");
 			if(!vcd_file_name.empty())
-				inductstep.dump_model_to_vcd(vcd_file_name);
+				induct.dump_model_to_vcd(vcd_file_name);
 			if(!json_file_name.empty())
-				inductstep.dump_model_to_json(json_file_name);
+				induct.dump_model_to_json(json_file_name);
 			print_proof_failed();
 
 		tip_failed:
@@ -1609,6 +1692,8 @@ struct SatPass : public Pass {
 			sathelper.set_init_zero = set_init_zero;
 			sathelper.satgen.ignore_div_by_zero = ignore_div_by_zero;
 			sathelper.ignore_unknown_cells = ignore_unknown_cells;
+			if (strash)
+				sathelper.enable_strash();
 
 			if (seq_len == 0) {
 				sathelper.setup();
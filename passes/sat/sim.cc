@@ -26,6 +26,7 @@
 #include "kernel/yw.h"
 #include "kernel/json.h"
 #include "kernel/fmt.h"
+#include "kernel/threading.h"
 
 #include <ctime>
 
@@ -68,12 +69,24 @@ static double stringToTime(std::string str)
 	return value * pow(10.0, g_units.at(endptr));
 }
 
+struct OutputStep
+{
+	int time;
+	// values of the signals that changed in this step, ordered by output id
+	std::vector<std::pair<int, Const>> changes;
+
+	OutputStep(int time) : time(time) { }
+};
+
 struct SimWorker;
 struct OutputWriter
 {
 	OutputWriter(SimWorker *w) { worker = w;};
 	virtual ~OutputWriter() {};
-	virtual void write(std::map<int, bool> &use_signal) = 0;
+	// called on the main thread once the set of dumped signals is known
+	virtual void write_header() = 0;
+	// called for each step in order, possibly on the output thread
+	virtual void write_step(const OutputStep &step) = 0;
 	SimWorker *worker;
 };
 
@@ -114,7 +127,8 @@ struct SimShared
 	SimulationMode sim_mode = SimulationMode::sim;
 	bool cycles_set = false;
 	std::vector<std::unique_ptr<OutputWriter>> outputfiles;
-	std::vector<std::pair<int,std::map<int,Const>>> output_data;
+	std::vector<OutputStep> output_data;
+	std::vector<bool> use_signal;
 	bool ignore_x = false;
 	bool date = false;
 	bool multiclock = false;
@@ -124,6 +138,7 @@ struct SimShared
 	std::vector<DisplayOutput> display_output;
 	bool serious_asserts = false;
 	bool initstate = true;
+	bool compile_gates = true;
 };
 
 void zinit(State &v)
@@ -150,14 +165,44 @@ struct SimInstance
 	dict<Cell*, SimInstance*> children;
 
 	SigMap sigmap;
-	dict<SigBit, State> state_nets;
-	dict<SigBit, pool<Cell*>> upd_cells;
-	dict<SigBit, pool<Wire*>> upd_outports;
+
+	// Every net (sigmapped wire bit) gets a dense id. Net values are stored
+	// in two packed bit-planes, encoding 0, 1, x and z as (hi,lo) = 00, 01,
+	// 10 and 11. Ids 0 to 3 are reserved for the constants 0, 1, x and z.
+	dict<SigBit, int> net_ids;
+	std::vector<uint64_t> net_lo, net_hi;
+
+	// Event-driven fanout of each net, as slices [start[id], start[id+1])
+	// of a flat list.
+	std::vector<int> upd_cells_start;
+	std::vector<Cell*> upd_cells_list;
+	std::vector<int> upd_outports_start;
+	std::vector<Wire*> upd_outports_list;
+
+	// Single-bit cells with at most four input bits are compiled into a
+	// levelised instruction array evaluated through per-cell truth tables.
+	// Cells on or behind combinational loops stay event-driven.
+	struct gate_insn_t
+	{
+		int y, a, b, c, d;
+		int table;
+	};
+
+	std::vector<gate_insn_t> gate_insns;
+	std::vector<uint8_t> gate_tables;
+	std::vector<int> gate_fanout_start;
+	std::vector<int> gate_fanout_list;
+	std::vector<bool> gate_dirty;
+	std::vector<bool> net_has_events;
+	int gate_dirty_min = INT_MAX;
 
 	dict<SigBit, SigBit> in_parent_drivers;
 	dict<SigBit, SigBit> clk2fflogic_drivers;
 
-	pool<SigBit> dirty_bits;
+	// Nets changed through set_state() and nets changed by the gate kernel
+	// that have event-driven readers.
+	std::vector<int> dirty_nets;
+	std::vector<int> dirty_event_nets;
 	pool<Cell*> dirty_cells;
 	pool<IdString> dirty_memories;
 	pool<SimInstance*, hash_ptr_ops> dirty_children;
@@ -244,16 +289,22 @@ struct SimInstance
 			parent->children[instance] = this;
 		}
 
+		for (auto bit : {State::S0, State::S1, State::Sx, State::Sz})
+			net_ids[bit] = GetSize(net_ids);
+
+		std::vector<std::pair<int, Wire*>> outport_bits;
+		std::vector<std::pair<SigBit, State>> init_bits;
+		std::vector<std::pair<int, Cell*>> upd_cells_bits;
+
 		for (auto wire : module->wires())
 		{
 			SigSpec sig = sigmap(wire);
 
 			for (int i = 0; i < GetSize(sig); i++) {
-				if (state_nets.count(sig[i]) == 0)
-					state_nets[sig[i]] = State::Sx;
+				int id = net_ids.emplace(sig[i], GetSize(net_ids)).first->second;
 				if (wire->port_output) {
-					upd_outports[sig[i]].insert(wire);
-					dirty_bits.insert(sig[i]);
+					outport_bits.emplace_back(id, wire);
+					dirty_nets.push_back(id);
 				}
 			}
 
@@ -267,10 +318,8 @@ struct SimInstance
 			if (wire->attributes.count(ID::init)) {
 				Const initval = wire->attributes.at(ID::init);
 				for (int i = 0; i < GetSize(sig) && i < GetSize(initval); i++)
-					if (initval[i] == State::S0 || initval[i] == State::S1) {
-						state_nets[sig[i]] = initval[i];
-						dirty_bits.insert(sig[i]);
-					}
+					if (initval[i] == State::S0 || initval[i] == State::S1)
+						init_bits.emplace_back(sig[i], initval[i]);
 			}
 
 			if (wire->port_input && instance != nullptr && parent != nullptr) {
@@ -281,6 +330,16 @@ struct SimInstance
 			}
 		}
 
+		net_lo.resize((GetSize(net_ids) + 63) / 64, 0);
+		net_hi.resize((GetSize(net_ids) + 63) / 64, ~uint64_t(0));
+		set_net(0, State::S0);
+		set_net(1, State::S1);
+		set_net(3, State::Sz);
+
+		for (auto &it : init_bits)
+			if (it.first.wire != nullptr && set_net(net_ids.at(it.first), it.second))
+				dirty_nets.push_back(net_ids.at(it.first));
+
 		memories = Mem::get_all_memories(module);
 		for (auto &mem : memories) {
 			auto &mdb = mem_database[mem.memid];
@@ -305,10 +364,11 @@ struct SimInstance
 			for (auto &port : cell->connections()) {
 				if (cell->input(port.first))
 					for (auto bit : sigmap(port.second)) {
-						upd_cells[bit].insert(cell);
+						if (bit.wire != nullptr)
+							upd_cells_bits.emplace_back(net_ids.at(bit), cell);
 						// Make sure cell inputs connected to constants are updated in the first cycle
-						if (bit.wire == nullptr)
-							dirty_bits.insert(bit);
+						else
+							dirty_cells.insert(cell);
 					}
 			}
 
@@ -357,6 +417,18 @@ struct SimInstance
 
 		std::sort(print_database.begin(), print_database.end());
 
+		std::vector<std::pair<int, int>> gate_fanout_bits;
+		if (shared->compile_gates)
+			compile_gates(upd_cells_bits, gate_fanout_bits);
+
+		build_fanout(gate_fanout_bits, gate_fanout_start, gate_fanout_list);
+		build_fanout(upd_cells_bits, upd_cells_start, upd_cells_list);
+		build_fanout(outport_bits, upd_outports_start, upd_outports_list);
+
+		net_has_events.resize(GetSize(net_ids));
+		for (int id = 0; id < GetSize(net_ids); id++)
+			net_has_events[id] = upd_cells_start[id] != upd_cells_start[id+1] || upd_outports_start[id] != upd_outports_start[id+1];
+
 		if (shared->zinit)
 		{
 			for (auto &it : ff_database)
@@ -380,6 +452,195 @@ struct SimInstance
 		}
 	}
 
+	template<typename T>
+	void build_fanout(std::vector<std::pair<int, T>> &entries, std::vector<int> &start, std::vector<T> &list)
+	{
+		std::sort(entries.begin(), entries.end());
+		entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+		start.assign(GetSize(net_ids) + 1, 0);
+		for (auto &it : entries)
+			start[it.first + 1]++;
+		for (int id = 0; id < GetSize(net_ids); id++)
+			start[id + 1] += start[id];
+
+		list.clear();
+		list.reserve(GetSize(entries));
+		for (auto &it : entries)
+			list.push_back(it.second);
+	}
+
+	// Returns the offset of the truth table for a single-output cell in
+	// gate_tables, or -1 if the cell can't be evaluated from a table. Inputs
+	// are the bits of A, B, C and S in that order, two bits per input.
+	int gate_table(Cell *cell, dict<std::pair<IdString, dict<IdString, Const>>, int> &cache)
+	{
+		auto key = std::make_pair(cell->type, cell->parameters);
+		auto it = cache.find(key);
+		if (it != cache.end())
+			return it->second;
+
+		static const State code_states[4] = {State::S0, State::S1, State::Sx, State::Sz};
+		const IdString ports[4] = {ID::A, ID::B, ID::C, ID::S};
+
+		int num_inputs = 0;
+		for (auto port : ports)
+			if (cell->hasPort(port))
+				num_inputs += GetSize(cell->getPort(port));
+
+		int offset = GetSize(gate_tables);
+		for (int index = 0; index < (1 << (2*num_inputs)); index++)
+		{
+			Const values[4];
+			int bit = 0;
+			for (int k = 0; k < 4; k++)
+				if (cell->hasPort(ports[k]))
+					for (int i = 0; i < GetSize(cell->getPort(ports[k])); i++, bit++)
+						values[k].bits.push_back(code_states[index >> (2*bit) & 3]);
+
+			bool err = false;
+			Const value;
+			if (!eval_cell(cell, values[0], values[1], values[2], values[3], value, &err) || err ||
+					GetSize(value) != 1 || (value[0] != State::S0 && value[0] != State::S1 && value[0] != State::Sx && value[0] != State::Sz)) {
+				gate_tables.resize(offset);
+				offset = -1;
+				break;
+			}
+			gate_tables.push_back(state_code(value[0]));
+		}
+
+		cache[key] = offset;
+		return offset;
+	}
+
+	void compile_gates(std::vector<std::pair<int, Cell*>> &upd_cells_bits, std::vector<std::pair<int, int>> &fanout_bits)
+	{
+		struct candidate_t {
+			Cell *cell;
+			int y;
+			std::vector<int> inputs;
+			int table;
+			int pending;
+		};
+
+		dict<std::pair<IdString, dict<IdString, Const>>, int> table_cache;
+		std::vector<candidate_t> candidates;
+		std::vector<int> net_driver(GetSize(net_ids), -1);
+
+		for (auto cell : module->cells())
+		{
+			if (!yosys_celltypes.cell_evaluable(cell->type) || ff_database.count(cell) || formal_database.count(cell) ||
+					mem_cells.count(cell) || children.count(cell))
+				continue;
+
+			// The three-input paths of CellTypes::eval() have no error reporting
+			if ((cell->hasPort(ID::C) || cell->hasPort(ID::S)) && !cell->type.in(ID($_MUX_), ID($mux), ID($_AOI3_), ID($_OAI3_)))
+				continue;
+
+			if (!cell->hasPort(ID::Y) || GetSize(cell->getPort(ID::Y)) != 1)
+				continue;
+
+			candidate_t cand;
+			cand.cell = cell;
+			cand.y = -1;
+			cand.pending = 0;
+
+			bool ok = true;
+			for (auto &conn : cell->connections()) {
+				if (!conn.first.in(ID::A, ID::B, ID::C, ID::S, ID::Y)) {
+					ok = false;
+					break;
+				}
+				if (conn.first == ID::Y) {
+					SigBit bit = sigmap(conn.second[0]);
+					if (bit.wire == nullptr)
+						ok = false;
+					else
+						cand.y = net_ids.at(bit);
+				}
+			}
+
+			for (auto port : {ID::A, ID::B, ID::C, ID::S})
+				if (ok && cell->hasPort(port))
+					for (auto bit : sigmap(cell->getPort(port))) {
+						auto it = net_ids.find(bit);
+						if (it == net_ids.end() || GetSize(cand.inputs) == 4) {
+							ok = false;
+							break;
+						}
+						cand.inputs.push_back(it->second);
+					}
+
+			if (!ok)
+				continue;
+
+			cand.table = gate_table(cell, table_cache);
+			if (cand.table < 0)
+				continue;
+
+			int idx = GetSize(candidates);
+			net_driver[cand.y] = net_driver[cand.y] == -1 ? idx : -2;
+			candidates.push_back(std::move(cand));
+		}
+
+		// Levelise with Kahn's algorithm; nets driven by more than one
+		// candidate are left to the event-driven path.
+		std::vector<std::vector<int>> readers(GetSize(candidates));
+		std::vector<int> queue;
+
+		for (int idx = 0; idx < GetSize(candidates); idx++) {
+			auto &cand = candidates[idx];
+			if (net_driver[cand.y] != idx)
+				continue;
+			for (int id : cand.inputs) {
+				int driver = net_driver[id];
+				if (driver >= 0) {
+					readers[driver].push_back(idx);
+					cand.pending++;
+				} else if (driver == -2)
+					cand.pending = INT_MAX / 2;
+			}
+			if (cand.pending == 0)
+				queue.push_back(idx);
+		}
+
+		for (int i = 0; i < GetSize(queue); i++)
+			for (int idx : readers[queue[i]])
+				if (--candidates[idx].pending == 0)
+					queue.push_back(idx);
+
+		pool<Cell*> compiled;
+
+		for (int idx : queue)
+		{
+			auto &cand = candidates[idx];
+			gate_insn_t insn;
+			insn.y = cand.y;
+			insn.a = GetSize(cand.inputs) > 0 ? cand.inputs[0] : 0;
+			insn.b = GetSize(cand.inputs) > 1 ? cand.inputs[1] : 0;
+			insn.c = GetSize(cand.inputs) > 2 ? cand.inputs[2] : 0;
+			insn.d = GetSize(cand.inputs) > 3 ? cand.inputs[3] : 0;
+			insn.table = cand.table;
+
+			int k = GetSize(gate_insns);
+			for (int id : cand.inputs)
+				if (id >= 4)
+					fanout_bits.emplace_back(id, k);
+
+			gate_insns.push_back(insn);
+			gate_dirty.push_back(dirty_cells.erase(cand.cell) != 0);
+			if (gate_dirty.back())
+				gate_dirty_min = std::min(gate_dirty_min, k);
+			compiled.insert(cand.cell);
+		}
+
+		upd_cells_bits.erase(std::remove_if(upd_cells_bits.begin(), upd_cells_bits.end(),
+				[&](const std::pair<int, Cell*> &it) { return compiled.count(it.second) != 0; }), upd_cells_bits.end());
+
+		if (shared->debug)
+			log("[%s] compiled %d of %d cells into levelised gate kernel\n", hiername().c_str(), GetSize(gate_insns), GetSize(module->cells()));
+	}
+
 	~SimInstance()
 	{
 		for (auto child : children)
@@ -416,6 +677,48 @@ struct SimInstance
 		return result;
 	}
 
+	int get_net_code(int id) const
+	{
+		return (net_lo[id >> 6] >> (id & 63) & 1) | (net_hi[id >> 6] >> (id & 63) & 1) << 1;
+	}
+
+	bool set_net_code(int id, int code)
+	{
+		uint64_t mask = uint64_t(1) << (id & 63);
+		uint64_t lo = (code & 1) ? mask : 0;
+		uint64_t hi = (code & 2) ? mask : 0;
+		uint64_t &word_lo = net_lo[id >> 6];
+		uint64_t &word_hi = net_hi[id >> 6];
+
+		if ((word_lo & mask) == lo && (word_hi & mask) == hi)
+			return false;
+
+		word_lo = (word_lo & ~mask) | lo;
+		word_hi = (word_hi & ~mask) | hi;
+		return true;
+	}
+
+	static int state_code(State value)
+	{
+		switch (value) {
+			case State::S0: return 0;
+			case State::S1: return 1;
+			case State::Sz: return 3;
+			default: return 2;
+		}
+	}
+
+	State get_net(int id) const
+	{
+		static const State code_states[4] = {State::S0, State::S1, State::Sx, State::Sz};
+		return code_states[get_net_code(id)];
+	}
+
+	bool set_net(int id, State value)
+	{
+		return set_net_code(id, state_code(value));
+	}
+
 	Const get_state(SigSpec sig)
 	{
 		Const value;
@@ -423,10 +726,10 @@ struct SimInstance
 		for (auto bit : sigmap(sig))
 			if (bit.wire == nullptr)
 				value.bits.push_back(bit.data);
-			else if (state_nets.count(bit))
-				value.bits.push_back(state_nets.at(bit));
-			else
-				value.bits.push_back(State::Sz);
+			else {
+				auto it = net_ids.find(bit);
+				value.bits.push_back(it != net_ids.end() ? get_net(it->second) : State::Sz);
+			}
 
 		if (shared->debug)
 			log("[%s] get %s: %s\n", hiername().c_str(), log_signal(sig), log_signal(value));
@@ -440,12 +743,15 @@ struct SimInstance
 		sig = sigmap(sig);
 		log_assert(GetSize(sig) <= GetSize(value));
 
-		for (int i = 0; i < GetSize(sig); i++)
-			if (value[i] != State::Sa && state_nets.at(sig[i]) != value[i]) {
-				state_nets.at(sig[i]) = value[i];
-				dirty_bits.insert(sig[i]);
+		for (int i = 0; i < GetSize(sig); i++) {
+			if (value[i] == State::Sa || sig[i].wire == nullptr)
+				continue;
+			int id = net_ids.at(sig[i]);
+			if (set_net(id, value[i])) {
+				dirty_nets.push_back(id);
 				did_something = true;
 			}
+		}
 
 		if (shared->debug)
 			log("[%s] set %s: %s\n", hiername().c_str(), log_signal(sig), log_signal(value));
@@ -504,6 +810,46 @@ struct SimInstance
 		}
 	}
 
+	// Evaluates an evaluable cell from the values of its input ports. Returns
+	// false if the combination of ports is not supported.
+	static bool eval_cell(Cell *cell, const Const &a, const Const &b, const Const &c, const Const &s, Const &y, bool *errp = nullptr)
+	{
+		bool has_a, has_b, has_c, has_d, has_s, has_y;
+
+		has_a = cell->hasPort(ID::A);
+		has_b = cell->hasPort(ID::B);
+		has_c = cell->hasPort(ID::C);
+		has_d = cell->hasPort(ID::D);
+		has_s = cell->hasPort(ID::S);
+		has_y = cell->hasPort(ID::Y);
+
+		// Simple (A -> Y) and (A,B -> Y) cells
+		if (has_a && !has_c && !has_d && !has_s && has_y) {
+			y = CellTypes::eval(cell, a, b, errp);
+			return true;
+		}
+
+		// (A,B,C -> Y) cells
+		if (has_a && has_b && has_c && !has_d && !has_s && has_y) {
+			y = CellTypes::eval(cell, a, b, c, errp);
+			return true;
+		}
+
+		// (A,S -> Y) cells
+		if (has_a && !has_b && !has_c && !has_d && has_s && has_y) {
+			y = CellTypes::eval(cell, a, s, errp);
+			return true;
+		}
+
+		// (A,B,S -> Y) cells
+		if (has_a && has_b && !has_c && !has_d && has_s && has_y) {
+			y = CellTypes::eval(cell, a, b, s, errp);
+			return true;
+		}
+
+		return false;
+	}
+
 	void update_cell(Cell *cell)
 	{
 		if (ff_database.count(cell))
@@ -532,47 +878,16 @@ struct SimInstance
 
 		if (yosys_celltypes.cell_evaluable(cell->type))
 		{
-			RTLIL::SigSpec sig_a, sig_b, sig_c, sig_d, sig_s, sig_y;
-			bool has_a, has_b, has_c, has_d, has_s, has_y;
-
-			has_a = cell->hasPort(ID::A);
-			has_b = cell->hasPort(ID::B);
-			has_c = cell->hasPort(ID::C);
-			has_d = cell->hasPort(ID::D);
-			has_s = cell->hasPort(ID::S);
-			has_y = cell->hasPort(ID::Y);
-
-			if (has_a) sig_a = cell->getPort(ID::A);
-			if (has_b) sig_b = cell->getPort(ID::B);
-			if (has_c) sig_c = cell->getPort(ID::C);
-			if (has_d) sig_d = cell->getPort(ID::D);
-			if (has_s) sig_s = cell->getPort(ID::S);
-			if (has_y) sig_y = cell->getPort(ID::Y);
-
 			if (shared->debug)
 				log("[%s] eval %s (%s)\n", hiername().c_str(), log_id(cell), log_id(cell->type));
 
-			// Simple (A -> Y) and (A,B -> Y) cells
-			if (has_a && !has_c && !has_d && !has_s && has_y) {
-				set_state(sig_y, CellTypes::eval(cell, get_state(sig_a), get_state(sig_b)));
-				return;
-			}
+			auto port_state = [&](IdString port) {
+				return cell->hasPort(port) ? get_state(cell->getPort(port)) : Const();
+			};
 
-			// (A,B,C -> Y) cells
-			if (has_a && has_b && has_c && !has_d && !has_s && has_y) {
-				set_state(sig_y, CellTypes::eval(cell, get_state(sig_a), get_state(sig_b), get_state(sig_c)));
-				return;
-			}
-
-			// (A,S -> Y) cells
-			if (has_a && !has_b && !has_c && !has_d && has_s && has_y) {
-				set_state(sig_y, CellTypes::eval(cell, get_state(sig_a), get_state(sig_s)));
-				return;
-			}
-
-			// (A,B,S -> Y) cells
-			if (has_a && has_b && !has_c && !has_d && has_s && has_y) {
-				set_state(sig_y, CellTypes::eval(cell, get_state(sig_a), get_state(sig_b), get_state(sig_s)));
+			Const value;
+			if (eval_cell(cell, port_state(ID::A), port_state(ID::B), port_state(ID::C), port_state(ID::S), value)) {
+				set_state(cell->getPort(ID::Y), value);
 				return;
 			}
 
@@ -614,6 +929,49 @@ struct SimInstance
 		}
 	}
 
+	void queue_net_events(int id, pool<Cell*> &queue_cells, pool<Wire*> &queue_outports)
+	{
+		for (int i = upd_cells_start[id]; i < upd_cells_start[id+1]; i++)
+			queue_cells.insert(upd_cells_list[i]);
+
+		if (parent != nullptr)
+			for (int i = upd_outports_start[id]; i < upd_outports_start[id+1]; i++)
+				queue_outports.insert(upd_outports_list[i]);
+	}
+
+	void mark_gate_fanout(int id)
+	{
+		for (int i = gate_fanout_start[id]; i < gate_fanout_start[id+1]; i++) {
+			int k = gate_fanout_list[i];
+			gate_dirty[k] = true;
+			gate_dirty_min = std::min(gate_dirty_min, k);
+		}
+	}
+
+	void update_gates()
+	{
+		int n = GetSize(gate_insns);
+
+		for (int i = gate_dirty_min; i < n; i++)
+		{
+			if (!gate_dirty[i])
+				continue;
+			gate_dirty[i] = false;
+
+			const gate_insn_t &insn = gate_insns[i];
+			int index = get_net_code(insn.a) | get_net_code(insn.b) << 2 | get_net_code(insn.c) << 4 | get_net_code(insn.d) << 6;
+
+			if (set_net_code(insn.y, gate_tables[insn.table + index])) {
+				// Levelised order: all gates reading y come after this one
+				mark_gate_fanout(insn.y);
+				if (net_has_events[insn.y])
+					dirty_event_nets.push_back(insn.y);
+			}
+		}
+
+		gate_dirty_min = INT_MAX;
+	}
+
 	void update_ph1()
 	{
 		pool<Cell*> queue_cells;
@@ -623,19 +981,26 @@ struct SimInstance
 
 		while (1)
 		{
-			for (auto bit : dirty_bits)
+			for (int id : dirty_nets) {
+				mark_gate_fanout(id);
+				queue_net_events(id, queue_cells, queue_outports);
+			}
+
+			for (int id : dirty_event_nets)
+				queue_net_events(id, queue_cells, queue_outports);
+
+			dirty_nets.clear();
+			dirty_event_nets.clear();
+
+			if (gate_dirty_min != INT_MAX)
 			{
-				if (upd_cells.count(bit))
-					for (auto cell : upd_cells.at(bit))
-						queue_cells.insert(cell);
+				if (shared->debug)
+					log("[%s] eval compiled gates\n", hiername().c_str());
 
-				if (upd_outports.count(bit) && parent != nullptr)
-					for (auto wire : upd_outports.at(bit))
-						queue_outports.insert(wire);
+				update_gates();
+				continue;
 			}
 
-			dirty_bits.clear();
-
 			if (!queue_cells.empty())
 			{
 				for (auto cell : queue_cells)
@@ -662,7 +1027,7 @@ struct SimInstance
 
 			dirty_children.clear();
 
-			if (dirty_bits.empty())
+			if (dirty_nets.empty() && dirty_event_nets.empty())
 				break;
 		}
 	}
@@ -1099,18 +1464,29 @@ struct SimInstance
 		int output_id = shared->next_output_id++;
 		Const data;
 		if (!shared->output_data.empty()) {
+			// output ids are handed out in increasing order, so this keeps the changes sorted
 			auto init_it = trace_mem_init_database.find(std::make_pair(memid, addr));
 			if (init_it != trace_mem_init_database.end())
 				data = init_it->second;
 			else
 				data = mem.get_init_data().extract(index * mem.width, mem.width);
-			shared->output_data.front().second.emplace(output_id, data);
+			shared->output_data.front().changes.emplace_back(output_id, data);
 		}
 		trace_mem_database[memid].emplace(index, make_pair(output_id, data));
 
 	}
 
-	void register_output_step_values(std::map<int,Const> *data)
+	bool has_memories()
+	{
+		if (!mem_database.empty())
+			return true;
+		for (auto child : children)
+			if (child.second->has_memories())
+				return true;
+		return false;
+	}
+
+	void register_output_step_values(std::vector<std::pair<int, Const>> *data)
 	{
 		for (auto &it : signal_database)
 		{
@@ -1122,7 +1498,7 @@ struct SimInstance
 				continue;
 
 			it.second.second = value;
-			data->emplace(id, value);
+			data->emplace_back(id, value);
 		}
 
 		for (auto &trace_mem : trace_mem_database)
@@ -1141,7 +1517,7 @@ struct SimInstance
 					continue;
 
 				trace_index.second.second = value;
-				data->emplace(output_id, value);
+				data->emplace_back(output_id, value);
 			}
 		}
 
@@ -1281,6 +1657,256 @@ struct SimInstance
 	}
 };
 
+// Index of the lowest set bit, x must be non-zero.
+static int lowest_bit(uint64_t x)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(x);
+#else
+	int i = 0;
+	while (((x >> i) & 1) == 0)
+		i++;
+	return i;
+#endif
+}
+
+static int count_bits(uint64_t x)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(x);
+#else
+	int n = 0;
+	for (; x != 0; x &= x - 1)
+		n++;
+	return n;
+#endif
+}
+
+// Two-valued, bit-parallel simulation of a flat gate-level module for
+// "sim -vectors". Every net holds WORDS machine words with one independent
+// input vector per bit lane. Clocked FFs are advanced once per cycle.
+struct VectorSim
+{
+	static const int WORDS = 4;
+	static const int LANES = 64 * WORDS;
+
+	enum op_t {
+		OP_BUF, OP_NOT, OP_AND, OP_NAND, OP_OR, OP_NOR, OP_XOR, OP_XNOR,
+		OP_ANDNOT, OP_ORNOT, OP_MUX, OP_NMUX, OP_AOI3, OP_OAI3, OP_AOI4, OP_OAI4
+	};
+
+	struct insn_t
+	{
+		op_t op;
+		int y, a, b, c, d;
+	};
+
+	struct ff_t
+	{
+		int d, q, ce, srst, arst;
+		bool pol_ce, pol_srst, pol_arst, ce_over_srst;
+		bool val_srst, val_arst, val_init;
+	};
+
+	Module *module;
+	SigMap sigmap;
+	dict<SigBit, int> net_ids;
+	std::vector<insn_t> insns;
+	std::vector<ff_t> ffs;
+	std::vector<uint64_t> values;
+	std::vector<uint64_t> ff_next;
+
+	VectorSim(Module *module) : module(module), sigmap(module)
+	{
+		// Net 0 is constant 0 (x and z are simulated as 0), net 1 is constant 1.
+		net_ids[State::S0] = 0;
+		net_ids[State::S1] = 1;
+
+		static const dict<IdString, op_t> gate_ops = {
+			{ID($_BUF_), OP_BUF}, {ID($_NOT_), OP_NOT}, {ID($_AND_), OP_AND}, {ID($_NAND_), OP_NAND},
+			{ID($_OR_), OP_OR}, {ID($_NOR_), OP_NOR}, {ID($_XOR_), OP_XOR}, {ID($_XNOR_), OP_XNOR},
+			{ID($_ANDNOT_), OP_ANDNOT}, {ID($_ORNOT_), OP_ORNOT}, {ID($_MUX_), OP_MUX}, {ID($_NMUX_), OP_NMUX},
+			{ID($_AOI3_), OP_AOI3}, {ID($_OAI3_), OP_OAI3}, {ID($_AOI4_), OP_AOI4}, {ID($_OAI4_), OP_OAI4}
+		};
+
+		std::vector<insn_t> gates;
+		dict<int, int> gate_driver;
+
+		for (auto cell : module->cells())
+		{
+			if (RTLIL::builtin_ff_cell_types().count(cell->type)) {
+				FfData ff(nullptr, cell);
+				if (ff.has_aload || ff.has_sr || (!ff.has_clk && !ff.has_gclk))
+					log_error("FF cell %s.%s (%s) is not supported by bit-parallel simulation.\n", log_id(module), log_id(cell), log_id(cell->type));
+				for (int i = 0; i < ff.width; i++) {
+					ff_t f;
+					f.d = net(ff.sig_d[i]);
+					f.q = net(ff.sig_q[i]);
+					f.ce = ff.has_ce ? net(ff.sig_ce[0]) : 1;
+					f.pol_ce = ff.has_ce ? ff.pol_ce : true;
+					f.srst = ff.has_srst ? net(ff.sig_srst[0]) : 0;
+					f.pol_srst = ff.has_srst ? ff.pol_srst : true;
+					f.arst = ff.has_arst ? net(ff.sig_arst[0]) : 0;
+					f.pol_arst = ff.has_arst ? ff.pol_arst : true;
+					f.ce_over_srst = ff.ce_over_srst;
+					f.val_srst = ff.has_srst && ff.val_srst[i] == State::S1;
+					f.val_arst = ff.has_arst && ff.val_arst[i] == State::S1;
+					f.val_init = ff.val_init[i] == State::S1;
+					ffs.push_back(f);
+				}
+				continue;
+			}
+
+			auto it = gate_ops.find(cell->type);
+			if (it == gate_ops.end())
+				log_error("Cell %s.%s (%s) is not supported by bit-parallel simulation, "
+						"flatten the design and map it to gate cells (e.g. using 'techmap') first.\n",
+						log_id(module), log_id(cell), log_id(cell->type));
+
+			insn_t insn;
+			insn.op = it->second;
+			insn.a = cell->hasPort(ID::A) ? net(cell->getPort(ID::A)) : 0;
+			insn.b = cell->hasPort(ID::B) ? net(cell->getPort(ID::B)) : 0;
+			insn.c = cell->hasPort(ID::C) ? net(cell->getPort(ID::C)) : 0;
+			insn.d = cell->hasPort(ID::D) ? net(cell->getPort(ID::D)) : 0;
+			if (cell->hasPort(ID::S))
+				insn.c = net(cell->getPort(ID::S));
+			insn.y = net(cell->getPort(ID::Y));
+			if (insn.y < 2)
+				log_error("Output of cell %s.%s (%s) is connected to a constant.\n", log_id(module), log_id(cell), log_id(cell->type));
+
+			if (gate_driver.count(insn.y))
+				log_error("Net %s in module %s has multiple drivers.\n", log_signal(cell->getPort(ID::Y)), log_id(module));
+			gate_driver[insn.y] = GetSize(gates);
+			gates.push_back(insn);
+		}
+
+		for (auto wire : module->wires())
+			for (auto bit : sigmap(wire))
+				if (bit.wire != nullptr)
+					net(bit);
+
+		// Levelise the gates, FF outputs and inputs are sources.
+		std::vector<std::vector<int>> readers(GetSize(gates));
+		std::vector<int> pending(GetSize(gates));
+		std::vector<int> queue;
+
+		for (int i = 0; i < GetSize(gates); i++) {
+			auto &g = gates[i];
+			for (int id : {g.a, g.b, g.c, g.d}) {
+				auto it = gate_driver.find(id);
+				if (it != gate_driver.end()) {
+					readers[it->second].push_back(i);
+					pending[i]++;
+				}
+			}
+			if (pending[i] == 0)
+				queue.push_back(i);
+		}
+
+		for (int i = 0; i < GetSize(queue); i++)
+			for (int k : readers[queue[i]])
+				if (--pending[k] == 0)
+					queue.push_back(k);
+
+		if (GetSize(queue) != GetSize(gates))
+			log_error("Module %s has combinational loops, not supported by bit-parallel simulation.\n", log_id(module));
+
+		for (int i : queue)
+			insns.push_back(gates[i]);
+
+		values.resize(GetSize(net_ids) * WORDS);
+		ff_next.resize(GetSize(ffs) * WORDS);
+	}
+
+	int net(SigBit bit)
+	{
+		bit = sigmap(bit);
+		if (bit.wire == nullptr && bit.data != State::S1)
+			bit = State::S0;
+		return net_ids.emplace(bit, GetSize(net_ids)).first->second;
+	}
+
+	int net(const SigSpec &sig)
+	{
+		log_assert(GetSize(sig) == 1);
+		return net(sig[0]);
+	}
+
+	uint64_t *word(int id)
+	{
+		return &values[id * WORDS];
+	}
+
+	void reset_state()
+	{
+		std::fill(values.begin(), values.end(), 0);
+		std::fill(values.begin() + WORDS, values.begin() + 2*WORDS, ~uint64_t(0));
+		for (auto &f : ffs)
+			std::fill(word(f.q), word(f.q) + WORDS, f.val_init ? ~uint64_t(0) : 0);
+	}
+
+	void eval()
+	{
+		for (auto &insn : insns)
+		{
+			uint64_t *y = word(insn.y);
+			const uint64_t *a = word(insn.a), *b = word(insn.b), *c = word(insn.c), *d = word(insn.d);
+
+			switch (insn.op)
+			{
+			#define VECTOR_OP(_op, _expr) \
+				case _op: for (int k = 0; k < WORDS; k++) y[k] = (_expr); break;
+			VECTOR_OP(OP_BUF, a[k])
+			VECTOR_OP(OP_NOT, ~a[k])
+			VECTOR_OP(OP_AND, a[k] & b[k])
+			VECTOR_OP(OP_NAND, ~(a[k] & b[k]))
+			VECTOR_OP(OP_OR, a[k] | b[k])
+			VECTOR_OP(OP_NOR, ~(a[k] | b[k]))
+			VECTOR_OP(OP_XOR, a[k] ^ b[k])
+			VECTOR_OP(OP_XNOR, ~(a[k] ^ b[k]))
+			VECTOR_OP(OP_ANDNOT, a[k] & ~b[k])
+			VECTOR_OP(OP_ORNOT, a[k] | ~b[k])
+			VECTOR_OP(OP_MUX, (a[k] & ~c[k]) | (b[k] & c[k]))
+			VECTOR_OP(OP_NMUX, ~((a[k] & ~c[k]) | (b[k] & c[k])))
+			VECTOR_OP(OP_AOI3, ~((a[k] & b[k]) | c[k]))
+			VECTOR_OP(OP_OAI3, ~((a[k] | b[k]) & c[k]))
+			VECTOR_OP(OP_AOI4, ~((a[k] & b[k]) | (c[k] & d[k])))
+			VECTOR_OP(OP_OAI4, ~((a[k] | b[k]) & (c[k] | d[k])))
+			#undef VECTOR_OP
+			}
+		}
+	}
+
+	// Advances all FFs by one clock cycle. Async resets are sampled like
+	// sync resets, which matches resets driven for whole cycles.
+	void clock()
+	{
+		for (int i = 0; i < GetSize(ffs); i++)
+		{
+			auto &f = ffs[i];
+			const uint64_t *d = word(f.d), *q = word(f.q), *ce = word(f.ce), *srst = word(f.srst), *arst = word(f.arst);
+			uint64_t *next = &ff_next[i * WORDS];
+			uint64_t val_srst = f.val_srst ? ~uint64_t(0) : 0;
+			uint64_t val_arst = f.val_arst ? ~uint64_t(0) : 0;
+
+			for (int k = 0; k < WORDS; k++) {
+				uint64_t en = f.pol_ce ? ce[k] : ~ce[k];
+				uint64_t rst = f.pol_srst ? srst[k] : ~srst[k];
+				if (f.ce_over_srst)
+					rst &= en;
+				uint64_t v = (d[k] & en) | (q[k] & ~en);
+				v = (val_srst & rst) | (v & ~rst);
+				uint64_t ar = f.pol_arst ? arst[k] : ~arst[k];
+				next[k] = (val_arst & ar) | (v & ~ar);
+			}
+		}
+
+		for (int i = 0; i < GetSize(ffs); i++)
+			std::copy(&ff_next[i * WORDS], &ff_next[(i+1) * WORDS], word(ffs[i].q));
+	}
+};
+
 struct SimWorker : SimShared
 {
 	SimInstance *top = nullptr;
@@ -1291,8 +1917,18 @@ struct SimWorker : SimShared
 	std::string summary_filename;
 	std::string scope;
 
+	// Waveform steps are handed to the output thread in batches of at
+	// least this many value changes.
+	static constexpr int output_batch_changes = 16384;
+
+	std::unique_ptr<ConcurrentQueue<std::vector<OutputStep>>> output_queue;
+	std::unique_ptr<ThreadPool> output_thread;
+	std::vector<OutputStep> output_batch;
+	int output_batch_size = 0;
+
 	~SimWorker()
 	{
+		stop_output_thread();
 		outputfiles.clear();
 		delete top;
 	}
@@ -1303,32 +1939,115 @@ struct SimWorker : SimShared
 		top->register_signals(top->shared->next_output_id);
 	}
 
+	void update_use_signal(const OutputStep &step, bool first)
+	{
+		if (GetSize(use_signal) < next_output_id)
+			use_signal.resize(next_output_id);
+		for (auto &data : step.changes)
+			use_signal[data.first] = !first || !data.second.is_fully_undef();
+	}
+
+	void write_output_headers()
+	{
+		for (auto &writer : outputfiles)
+			writer->write_header();
+	}
+
+	// Once the first step is recorded the set of dumped signals is final,
+	// unless -x needs to see the whole trace or memory words are added to
+	// the trace as they get accessed. In that case everything is buffered
+	// until the end of the simulation.
+	void start_output_thread()
+	{
+		if (ignore_x || top->has_memories() || ThreadPool::pool_size(1, 1) == 0)
+			return;
+
+		update_use_signal(output_data.front(), false);
+		write_output_headers();
+
+		output_queue.reset(new ConcurrentQueue<std::vector<OutputStep>>(16));
+		output_thread.reset(new ThreadPool(1, [this](int) {
+			while (auto batch = output_queue->pop_front())
+				for (auto &step : *batch)
+					for (auto &writer : outputfiles)
+						writer->write_step(step);
+		}));
+
+		output_batch = std::move(output_data);
+		output_batch_size = GetSize(output_batch.front().changes);
+		output_data.clear();
+	}
+
+	void flush_output_batch()
+	{
+		output_queue->push_back(std::move(output_batch));
+		output_batch.clear();
+		output_batch_size = 0;
+	}
+
+	void stop_output_thread()
+	{
+		if (output_thread == nullptr)
+			return;
+		output_queue->close();
+		output_thread->join();
+		output_thread.reset();
+		output_queue.reset();
+	}
+
 	void register_output_step(int t)
 	{
-		std::map<int,Const> data;
-		top->register_output_step_values(&data);
-		output_data.emplace_back(t, data);
+		if (outputfiles.empty())
+			return;
+
+		OutputStep step(t);
+		top->register_output_step_values(&step.changes);
+		std::sort(step.changes.begin(), step.changes.end(),
+				[](const std::pair<int, Const> &a, const std::pair<int, Const> &b) { return a.first < b.first; });
+
+		if (output_thread == nullptr) {
+			output_data.push_back(std::move(step));
+			if (GetSize(output_data) == 1)
+				start_output_thread();
+			return;
+		}
+
+		output_batch_size += GetSize(step.changes);
+		output_batch.push_back(std::move(step));
+		if (output_batch_size >= output_batch_changes)
+			flush_output_batch();
 	}
 
 	void write_output_files()
 	{
-		std::map<int, bool> use_signal;
-		bool first = ignore_x;
-		for(auto& d : output_data)
-		{
-			if (first) {
-				for (auto &data : d.second)
-					use_signal[data.first] = !data.second.is_fully_undef();
+		if (output_thread != nullptr) {
+			if (!output_batch.empty())
+				flush_output_batch();
+			stop_output_thread();
+		} else if (!outputfiles.empty() && !output_data.empty()) {
+			bool first = ignore_x;
+			for (auto &step : output_data) {
+				update_use_signal(step, first);
 				first = false;
-			} else {
-				for (auto &data : d.second)
-					use_signal[data.first] = true;
-			}
-			if (!ignore_x) break;
+				if (!ignore_x) break;
+			}
+			write_output_headers();
+
+			// Each writer produces its file on its own thread
+			int num_threads = ThreadPool::pool_size(0, GetSize(outputfiles));
+			auto write_steps = [this](int index) {
+				for (auto &step : output_data)
+					outputfiles[index]->write_step(step);
+			};
+			ThreadPool pool(num_threads, [&](int thread) {
+				for (int i = thread; i < GetSize(outputfiles); i += num_threads)
+					write_steps(i);
+			});
+			if (num_threads == 0)
+				for (int i = 0; i < GetSize(outputfiles); i++)
+					write_steps(i);
 		}
-		for(auto& writer : outputfiles)
-			writer->write(use_signal);
-		
+
 		if (writeback) {
 			pool<Module*> wbmods;
 			top->writeback(wbmods);
@@ -2053,6 +2772,143 @@ struct SimWorker : SimShared
 		write_output_files();
 	}
 
+	void run_vectors(Module *topmod, Module *cmpmod, int numcycles, int num_vectors, uint64_t seed)
+	{
+		VectorSim gate(topmod), gold(cmpmod);
+
+		struct port_t {
+			Wire *wire;
+			std::vector<int> gate_nets, gold_nets;
+		};
+		std::vector<port_t> inputs, outputs;
+
+		for (auto wire : topmod->wires())
+		{
+			if (!wire->port_input && !wire->port_output)
+				continue;
+
+			Wire *w = cmpmod->wire(wire->name);
+			if (w == nullptr || w->port_input != wire->port_input || w->port_output != wire->port_output || GetSize(w) != GetSize(wire))
+				log_error("Port %s of module %s has no matching port in module %s.\n", log_id(wire), log_id(topmod), log_id(cmpmod));
+
+			port_t port;
+			port.wire = wire;
+			for (int i = 0; i < GetSize(wire); i++) {
+				port.gate_nets.push_back(gate.net(SigBit(wire, i)));
+				port.gold_nets.push_back(gold.net(SigBit(w, i)));
+			}
+			(wire->port_input ? inputs : outputs).push_back(port);
+		}
+
+		log("Simulating %d random vectors for %d cycles, %d vectors in parallel.\n", num_vectors, numcycles, VectorSim::LANES);
+
+		// Stimulus of the current batch, indexed by cycle, input bit and word
+		int num_input_bits = 0;
+		for (auto &port : inputs)
+			num_input_bits += GetSize(port.wire);
+		std::vector<uint64_t> stimulus(numcycles * num_input_bits * VectorSim::WORDS);
+
+		int failed_vectors = 0;
+		bool reported = false;
+
+		for (int batch_start = 0; batch_start < num_vectors; batch_start += VectorSim::LANES)
+		{
+			gate.reset_state();
+			gold.reset_state();
+
+			uint64_t failed_lanes[VectorSim::WORDS] = {};
+
+			for (int cycle = 0; cycle < numcycles; cycle++)
+			{
+				int bit_idx = 0;
+				for (auto &port : inputs)
+				{
+					bool is_clock = clock.count(port.wire->name) || clockn.count(port.wire->name);
+					bool is_reset = reset.count(port.wire->name), is_resetn = resetn.count(port.wire->name);
+					bool in_reset = cycle < rstlen;
+
+					for (int i = 0; i < GetSize(port.wire); i++, bit_idx++)
+					{
+						uint64_t *stim = &stimulus[(cycle * num_input_bits + bit_idx) * VectorSim::WORDS];
+						for (int k = 0; k < VectorSim::WORDS; k++) {
+							if (is_clock)
+								stim[k] = 0;
+							else if (is_reset || is_resetn)
+								stim[k] = in_reset == is_reset ? ~uint64_t(0) : 0;
+							else {
+								seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+								stim[k] = seed;
+							}
+						}
+						if (port.gate_nets[i] >= 2)
+							std::copy(stim, stim + VectorSim::WORDS, gate.word(port.gate_nets[i]));
+						if (port.gold_nets[i] >= 2)
+							std::copy(stim, stim + VectorSim::WORDS, gold.word(port.gold_nets[i]));
+					}
+				}
+
+				gate.eval();
+				gold.eval();
+
+				for (auto &port : outputs)
+					for (int i = 0; i < GetSize(port.wire); i++)
+					{
+						const uint64_t *a = gate.word(port.gate_nets[i]), *b = gold.word(port.gold_nets[i]);
+						for (int k = 0; k < VectorSim::WORDS; k++)
+						{
+							uint64_t diff = a[k] ^ b[k];
+							if (batch_start + 64*k + 64 > num_vectors)
+								diff &= batch_start + 64*k >= num_vectors ? 0 : (uint64_t(1) << (num_vectors - batch_start - 64*k)) - 1;
+							if (diff == 0)
+								continue;
+							failed_lanes[k] |= diff;
+							if (!reported) {
+								reported = true;
+								int lane = 64*k + lowest_bit(diff);
+								report_vector_mismatch(port.wire, i, batch_start + lane, lane, cycle, inputs, stimulus, num_input_bits, a, b);
+							}
+						}
+					}
+
+				gate.clock();
+				gold.clock();
+			}
+
+			for (int k = 0; k < VectorSim::WORDS; k++)
+				failed_vectors += count_bits(failed_lanes[k]);
+		}
+
+		if (failed_vectors)
+			log_error("%d of %d random vectors show differences between modules %s and %s.\n", failed_vectors, num_vectors, log_id(topmod), log_id(cmpmod));
+		log("All %d random vectors match between modules %s and %s.\n", num_vectors, log_id(topmod), log_id(cmpmod));
+	}
+
+	template<typename T>
+	void report_vector_mismatch(Wire *wire, int offset, int vector, int lane, int cycle, const std::vector<T> &inputs,
+			const std::vector<uint64_t> &stimulus, int num_input_bits, const uint64_t *gate_val, const uint64_t *gold_val)
+	{
+		auto lane_bit = [&](const uint64_t *words) {
+			return (words[lane / 64] >> (lane % 64) & 1) ? '1' : '0';
+		};
+
+		log("Mismatch for vector %d in cycle %d: %s[%d] is %c, expected %c.\n", vector, cycle, log_id(wire), offset,
+				lane_bit(gate_val), lane_bit(gold_val));
+		log("Input sequence of vector %d:\n", vector);
+
+		for (int c = 0; c <= cycle; c++)
+		{
+			std::string line;
+			int bit_idx = 0;
+			for (auto &port : inputs) {
+				std::string value;
+				for (int i = 0; i < GetSize(port.wire); i++, bit_idx++)
+					value = lane_bit(&stimulus[(c * num_input_bits + bit_idx) * VectorSim::WORDS]) + value;
+				line += stringf(" %s=%s", log_id(port.wire), value.c_str());
+			}
+			log("  cycle %d:%s\n", c, line.c_str());
+		}
+	}
+
 	void write_summary()
 	{
 		if (summary_filename.empty())
@@ -2334,13 +3190,25 @@ std::string form_vcd_name(const char *name, int size, Wire *w)
 	return full_name;
 }
 
+static void append_vcd_value(std::string &buf, const Const &value)
+{
+	for (int i = GetSize(value)-1; i >= 0; i--) {
+		switch (value[i]) {
+			case State::S0: buf += '0'; break;
+			case State::S1: buf += '1'; break;
+			case State::Sx: buf += 'x'; break;
+			default: buf += 'z';
+		}
+	}
+}
+
 struct VCDWriter : public OutputWriter
 {
 	VCDWriter(SimWorker *worker, std::string filename) : OutputWriter(worker) {
 		vcdfile.open(filename.c_str());
 	}
 
-	void write(std::map<int, bool> &use_signal) override
+	void write_header() override
 	{
 		if (!vcdfile.is_open()) return;
 		vcdfile << stringf("$version %s $end\n", worker->date ? yosys_version_str : "Yosys");
@@ -2359,8 +3227,8 @@ struct VCDWriter : public OutputWriter
 		worker->top->write_output_header(
 			[this](IdString name) { vcdfile << stringf("$scope module %s $end\n", log_id(name)); },
 			[this]() { vcdfile << stringf("$upscope $end\n");},
-			[this,use_signal](const char *name, int size, Wire *w, int id, bool is_reg) {
-				if (!use_signal.at(id)) return;
+			[this](const char *name, int size, Wire *w, int id, bool is_reg) {
+				if (!worker->use_signal.at(id)) return;
 				// Works around gtkwave trying to parse everything past the last [ in a signal
 				// name. While the emitted range doesn't necessarily match the wire's range,
 				// this is consistent with the range gtkwave makes up if it doesn't find a
@@ -2371,29 +3239,25 @@ struct VCDWriter : public OutputWriter
 		);
 
 		vcdfile << stringf("$enddefinitions $end\n");
+	}
 
-		for(auto& d : worker->output_data)
+	void write_step(const OutputStep &step) override
+	{
+		if (!vcdfile.is_open()) return;
+		buf.clear();
+		buf += stringf("#%d\n", step.time);
+		for (auto &data : step.changes)
 		{
-			vcdfile << stringf("#%d\n", d.first);
-			for (auto &data : d.second)
-			{
-				if (!use_signal.at(data.first)) continue;
-				Const value = data.second;
-				vcdfile << "b";
-				for (int i = GetSize(value)-1; i >= 0; i--) {
-					switch (value[i]) {
-						case State::S0: vcdfile << "0"; break;
-						case State::S1: vcdfile << "1"; break;
-						case State::Sx: vcdfile << "x"; break;
-						default: vcdfile << "z";
-					}
-				}
-				vcdfile << stringf(" n%d\n", data.first);
-			}
+			if (!worker->use_signal.at(data.first)) continue;
+			buf += 'b';
+			append_vcd_value(buf, data.second);
+			buf += stringf(" n%d\n", data.first);
 		}
+		vcdfile << buf;
 	}
 
 	std::ofstream vcdfile;
+	std::string buf;
 };
 
 struct FSTWriter : public OutputWriter
@@ -2407,7 +3271,7 @@ struct FSTWriter : public OutputWriter
 		fstWriterClose(fstfile);
 	}
 
-	void write(std::map<int, bool> &use_signal) override
+	void write_header() override
 	{
 		if (!fstfile) return;
 		std::time_t t = std::time(nullptr);
@@ -2425,38 +3289,34 @@ struct FSTWriter : public OutputWriter
 	   	worker->top->write_output_header(
 			[this](IdString name) { fstWriterSetScope(fstfile, FST_ST_VCD_MODULE, stringf("%s",log_id(name)).c_str(), nullptr); },
 			[this]() { fstWriterSetUpscope(fstfile); },
-			[this,use_signal](const char *name, int size, Wire *w, int id, bool is_reg) {
-				if (!use_signal.at(id)) return;
+			[this](const char *name, int size, Wire *w, int id, bool is_reg) {
+				if (!worker->use_signal.at(id)) return;
 				std::string full_name = form_vcd_name(name, size, w);
 				fstHandle fst_id = fstWriterCreateVar(fstfile, is_reg ? FST_VT_VCD_REG : FST_VT_VCD_WIRE, FST_VD_IMPLICIT, size,
 												full_name.c_str(), 0);
-				mapping.emplace(id, fst_id);
+				if (GetSize(mapping) <= id)
+					mapping.resize(id + 1);
+				mapping[id] = fst_id;
 			}
 		);
+	}
 
-		for(auto& d : worker->output_data)
+	void write_step(const OutputStep &step) override
+	{
+		if (!fstfile) return;
+		fstWriterEmitTimeChange(fstfile, step.time);
+		for (auto &data : step.changes)
 		{
-			fstWriterEmitTimeChange(fstfile, d.first);
-			for (auto &data : d.second)
-			{
-				if (!use_signal.at(data.first)) continue;
-				Const value = data.second;
-				std::stringstream ss;
-				for (int i = GetSize(value)-1; i >= 0; i--) {
-					switch (value[i]) {
-						case State::S0: ss << "0"; break;
-						case State::S1: ss << "1"; break;
-						case State::Sx: ss << "x"; break;
-						default: ss << "z";
-					}
-				}
-				fstWriterEmitValueChange(fstfile, mapping[data.first], ss.str().c_str());
-			}
+			if (!worker->use_signal.at(data.first)) continue;
+			buf.clear();
+			append_vcd_value(buf, data.second);
+			fstWriterEmitValueChange(fstfile, mapping[data.first], buf.c_str());
 		}
 	}
 
 	struct fstContext *fstfile = nullptr;
-	std::map<int,fstHandle> mapping;
+	std::vector<fstHandle> mapping;
+	std::string buf;
 };
 
 struct AIWWriter : public OutputWriter
@@ -2470,7 +3330,7 @@ struct AIWWriter : public OutputWriter
 		aiwfile << '.' << '\n';
 	}
 
-	void write(std::map<int, bool> &) override
+	void write_header() override
 	{
 		if (!aiwfile.is_open()) return;
 		if (worker->map_filename.empty())
@@ -2479,7 +3339,6 @@ struct AIWWriter : public OutputWriter
 		std::ifstream mf(worker->map_filename);
 		std::string type, symbol;
 		int variable, index;
-		int max_input = 0;
 		if (mf.fail())
 			log_cmd_error("Not able to read AIGER witness map file.\n");
 		while (mf >> type >> variable >> index >> symbol) {
@@ -2514,63 +3373,67 @@ struct AIWWriter : public OutputWriter
 			[this](const char */*name*/, int /*size*/, Wire *wire, int id, bool) { if (wire != nullptr) mapping[wire] = id; }
 		);
 
-		std::map<int, Yosys::RTLIL::Const> current;
-		bool first = true;
-		for (auto iter = worker->output_data.begin(); iter != std::prev(worker->output_data.end()); ++iter)
-		{
-			auto& d = *iter;
-			for (auto &data : d.second)
+		current.resize(worker->next_output_id);
+	}
+
+	// The values after the last step are not part of the witness, so each
+	// step is only written once the next one arrives.
+	void write_step(const OutputStep &step) override
+	{
+		if (!aiwfile.is_open()) return;
+		if (pending)
+			write_current();
+		for (auto &data : step.changes)
+			current[data.first] = data.second;
+		pending = true;
+	}
+
+	void write_current()
+	{
+		if (first) {
+			for (int i = 0;; i++)
 			{
-				current[data.first] = data.second;
-			}
-			if (first) {
-				for (int i = 0;; i++)
-				{
-					if (aiw_latches.count(i)) {
-						aiwfile << '0';
-						continue;
-					}
-					aiwfile << '\n';
-					break;
+				if (aiw_latches.count(i)) {
+					aiwfile << '0';
+					continue;
 				}
-				first = false;
+				aiwfile << '\n';
+				break;
 			}
+			first = false;
+		}
 
-			bool skip = false;
-			for (auto it : clocks)
-			{
-				auto val = it.second ? State::S1 : State::S0;
-				SigBit bit = aiw_inputs.at(it.first);
+		for (auto it : clocks)
+		{
+			auto val = it.second ? State::S1 : State::S0;
+			SigBit bit = aiw_inputs.at(it.first);
+			auto v = current[mapping[bit.wire]].bits.at(bit.offset);
+			if (v == val)
+				return;
+		}
+		for (int i = 0; i <= max_input; i++)
+		{
+			if (aiw_inputs.count(i)) {
+				SigBit bit = aiw_inputs.at(i);
 				auto v = current[mapping[bit.wire]].bits.at(bit.offset);
-				if (v == val)
-					skip = true;
+				if (v == State::S1)
+					aiwfile << '1';
+				else
+					aiwfile << '0';
+				continue;
 			}
-			if (skip)
+			if (aiw_inits.count(i)) {
+				SigBit bit = aiw_inits.at(i);
+				auto v = current[mapping[bit.wire]].bits.at(bit.offset);
+				if (v == State::S1)
+					aiwfile << '1';
+				else
+					aiwfile << '0';
 				continue;
-			for (int i = 0; i <= max_input; i++)
-			{
-				if (aiw_inputs.count(i)) {
-					SigBit bit = aiw_inputs.at(i);
-					auto v = current[mapping[bit.wire]].bits.at(bit.offset);
-					if (v == State::S1)
-						aiwfile << '1';
-					else
-						aiwfile << '0';
-					continue;
-				}
-				if (aiw_inits.count(i)) {
-					SigBit bit = aiw_inits.at(i);
-					auto v = current[mapping[bit.wire]].bits.at(bit.offset);
-					if (v == State::S1)
-						aiwfile << '1';
-					else
-						aiwfile << '0';
-					continue;
-				}
-				aiwfile << '0';
 			}
-			aiwfile << '\n';
-		} 
+			aiwfile << '0';
+		}
+		aiwfile << '\n';
 	}
 
 	std::ofstream aiwfile;
@@ -2578,6 +3441,10 @@ struct AIWWriter : public OutputWriter
 	dict<int, SigBit> aiw_inputs, aiw_inits;
 	dict<int, bool> clocks;
 	std::map<Wire*,int> mapping;
+	int max_input = 0;
+	std::vector<Const> current;
+	bool first = true;
+	bool pending = false;
 };
 
 struct SimPass : public Pass {
@@ -2694,6 +3561,28 @@ struct SimPass : public Pass {
 		log("    -d\n");
 		log("        enable debug output\n");
 		log("\n");
+		log("    -vectors <integer>\n");
+		log("        bit-parallel random simulation: simulate the given number of\n");
+		log("        independent random input sequences of -n cycles each, and compare\n");
+		log("        the outputs of the top module with those of the module given with\n");
+		log("        -vectors-cmp. Vectors are simulated 256 at a time, packed into\n");
+		log("        machine words. Both modules must be flat and mapped to internal gate\n");
+		log("        cells and FFs (e.g. using 'flatten; techmap'), they are simulated\n");
+		log("        two-valued with x treated as 0. Ports given with -clock/-clockn are\n");
+		log("        held low and FFs advance once per cycle, ports given with\n");
+		log("        -reset/-resetn are active for the first -rstlen cycles. The first\n");
+		log("        mismatch is reported together with its input sequence.\n");
+		log("\n");
+		log("    -vectors-cmp <module>\n");
+		log("        reference module for -vectors, with the same ports as the top module\n");
+		log("\n");
+		log("    -seed <integer>\n");
+		log("        seed for the random vectors of -vectors (default: 1)\n");
+		log("\n");
+		log("    -nocompile\n");
+		log("        do not compile single-bit cells into a levelised gate kernel,\n");
+		log("        evaluate all cells event-driven instead\n");
+		log("\n");
 	}
 
 
@@ -2708,6 +3597,9 @@ struct SimPass : public Pass {
 		int numcycles = 20;
 		int append = 0;
 		bool start_set = false, stop_set = false, at_set = false;
+		int num_vectors = 0;
+		IdString vectors_cmp;
+		uint64_t seed = 1;
 
 		log_header(design, "Executing SIM pass (simulate the circuit).\n");
 
@@ -2744,6 +3636,22 @@ struct SimPass : public Pass {
 				worker.initstate = false;
 				continue;
 			}
+			if (args[argidx] == "-vectors" && argidx+1 < args.size()) {
+				num_vectors = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-vectors-cmp" && argidx+1 < args.size()) {
+				vectors_cmp = RTLIL::escape_id(args[++argidx]);
+				continue;
+			}
+			if (args[argidx] == "-seed" && argidx+1 < args.size()) {
+				seed = atoll(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-nocompile") {
+				worker.compile_gates = false;
+				continue;
+			}
 			if (args[argidx] == "-rstlen" && argidx+1 < args.size()) {
 				worker.rstlen = atoi(args[++argidx].c_str());
 				continue;
@@ -2884,7 +3792,14 @@ struct SimPass : public Pass {
 			top_mod = mods.front();
 		}
 
-		if (worker.sim_filename.empty())
+		if (num_vectors > 0) {
+			Module *cmp_mod = vectors_cmp.empty() ? nullptr : design->module(vectors_cmp);
+			if (cmp_mod == nullptr)
+				log_cmd_error("Option -vectors requires a reference module given with -vectors-cmp.\n");
+			if (seed == 0)
+				log_cmd_error("Seed for -vectors must be non-zero.\n");
+			worker.run_vectors(top_mod, cmp_mod, numcycles, num_vectors, seed);
+		} else if (worker.sim_filename.empty())
 			worker.run(top_mod, numcycles);
 		else {
 			std::string filename_trim = file_base_name(worker.sim_filename);
@@ -28,16 +28,32 @@
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-IdString concat_name(RTLIL::Cell *cell, IdString object_name)
+// The part of a flattened name that only depends on the template object,
+// see concat_name() below.
+std::string name_suffix(IdString object_name)
 {
 	if (object_name[0] == '\\')
-		return stringf("%s.%s", cell->name.c_str(), object_name.c_str() + 1);
-	else {
-		std::string object_name_str = object_name.str();
-		if (object_name_str.substr(0, 8) == "$flatten")
-			object_name_str.erase(0, 8);
-		return stringf("$flatten%s.%s", cell->name.c_str(), object_name_str.c_str());
-	}
+		return std::string(".") + (object_name.c_str() + 1);
+	std::string object_name_str = object_name.str();
+	if (object_name_str.substr(0, 8) == "$flatten")
+		object_name_str.erase(0, 8);
+	return "." + object_name_str;
+}
+
+IdString concat_name(RTLIL::Cell *cell, bool is_public, const std::string &suffix)
+{
+	std::string name;
+	name.reserve(GetSize(cell->name.str()) + GetSize(suffix) + 8);
+	if (!is_public)
+		name = "$flatten";
+	name += cell->name.str();
+	name += suffix;
+	return name;
+}
+
+IdString concat_name(RTLIL::Cell *cell, IdString object_name)
+{
+	return concat_name(cell, object_name[0] == '\\', name_suffix(object_name));
 }
 
 template<class T>
@@ -55,12 +71,83 @@ void map_sigspec(const dict<RTLIL::Wire*, RTLIL::Wire*> &map, RTLIL::SigSpec &si
 	sig = chunks;
 }
 
+// Everything about a template module that does not depend on the instance
+// being flattened. This is computed once per template and reused for all of
+// its instances.
+struct FlattenTemplate
+{
+	struct Object {
+		bool is_public;
+		std::string suffix;
+	};
+
+	// Template wires and cells in copy order, with precomputed name suffixes
+	std::vector<std::pair<RTLIL::Wire*, Object>> wires;
+	std::vector<std::pair<RTLIL::Cell*, Object>> cells;
+
+	// Port wires by name, including positional "$<n>" names
+	dict<IdString, RTLIL::Wire*> ports;
+
+	// Template bits driven by a cell output or a connection
+	pool<SigBit> driven;
+
+	FlattenTemplate(RTLIL::Module *tpl)
+	{
+		wires.reserve(GetSize(tpl->wires_));
+		for (auto tpl_wire : tpl->wires()) {
+			wires.emplace_back(tpl_wire, Object{tpl_wire->name[0] == '\\', name_suffix(tpl_wire->name)});
+			if (tpl_wire->port_id > 0) {
+				ports.emplace(tpl_wire->name, tpl_wire);
+				ports.emplace(stringf("$%d", tpl_wire->port_id), tpl_wire);
+			}
+		}
+
+		cells.reserve(GetSize(tpl->cells_));
+		for (auto tpl_cell : tpl->cells()) {
+			cells.emplace_back(tpl_cell, Object{tpl_cell->name[0] == '\\', name_suffix(tpl_cell->name)});
+			for (auto &tpl_conn : tpl_cell->connections())
+				if (tpl_cell->output(tpl_conn.first))
+					for (auto bit : tpl_conn.second)
+						driven.insert(bit);
+		}
+
+		for (auto &tpl_conn : tpl->connections())
+			for (auto bit : tpl_conn.first)
+				driven.insert(bit);
+	}
+};
+
 struct FlattenWorker
 {
 	bool ignore_wb = false;
 	bool create_scopeinfo = true;
 	bool create_scopename = false;
 
+	dict<RTLIL::Module*, FlattenTemplate*> templates;
+
+	~FlattenWorker()
+	{
+		for (auto &it : templates)
+			delete it.second;
+	}
+
+	const FlattenTemplate &get_template(RTLIL::Module *tpl)
+	{
+		auto it = templates.find(tpl);
+		if (it == templates.end())
+			it = templates.emplace(tpl, new FlattenTemplate(tpl)).first;
+		return *it->second;
+	}
+
+	void invalidate_template(RTLIL::Module *tpl)
+	{
+		auto it = templates.find(tpl);
+		if (it != templates.end()) {
+			delete it->second;
+			templates.erase(it);
+		}
+	}
+
 	template<class T>
 	void map_attributes(RTLIL::Cell *cell, T *object, IdString orig_object_name)
 	{
@@ -109,6 +196,8 @@ struct FlattenWorker
 
 	void flatten_cell(RTLIL::Design *design, RTLIL::Module *module, RTLIL::Cell *cell, RTLIL::Module *tpl, SigMap &sigmap, std::vector<RTLIL::Cell*> &new_cells)
 	{
+		const FlattenTemplate &tpl_info = get_template(tpl);
+
 		// Copy the contents of the flattened cell
 
 		dict<IdString, IdString> memory_map;
@@ -120,14 +209,14 @@ struct FlattenWorker
 		}
 
 		dict<RTLIL::Wire*, RTLIL::Wire*> wire_map;
-		dict<IdString, IdString> positional_ports;
-		for (auto tpl_wire : tpl->wires()) {
-			if (tpl_wire->port_id > 0)
-				positional_ports.emplace(stringf("$%d", tpl_wire->port_id), tpl_wire->name);
+		wire_map.reserve(GetSize(tpl_info.wires));
+		for (auto &tpl_wire_it : tpl_info.wires) {
+			RTLIL::Wire *tpl_wire = tpl_wire_it.first;
+			IdString new_name = concat_name(cell, tpl_wire_it.second.is_public, tpl_wire_it.second.suffix);
 
 			RTLIL::Wire *new_wire = nullptr;
-			if (tpl_wire->name[0] == '\\') {
-				RTLIL::Wire *hier_wire = module->wire(concat_name(cell, tpl_wire->name));
+			if (tpl_wire_it.second.is_public) {
+				RTLIL::Wire *hier_wire = module->wire(new_name);
 				if (hier_wire != nullptr && hier_wire->get_bool_attribute(ID::hierconn)) {
 					hier_wire->attributes.erase(ID::hierconn);
 					if (GetSize(hier_wire) < GetSize(tpl_wire)) {
@@ -139,7 +228,7 @@ struct FlattenWorker
 				}
 			}
 			if (new_wire == nullptr) {
-				new_wire = module->addWire(map_name(cell, tpl_wire), tpl_wire);
+				new_wire = module->addWire(module->uniquify(new_name), tpl_wire);
 				new_wire->port_input = new_wire->port_output = false;
 				new_wire->port_id = false;
 			}
@@ -149,19 +238,21 @@ struct FlattenWorker
 			design->select(module, new_wire);
 		}
 
+		auto rewriter = [&](RTLIL::SigSpec &sig) { map_sigspec(wire_map, sig); };
 		for (auto &tpl_proc_it : tpl->processes) {
 			RTLIL::Process *new_proc = module->addProcess(map_name(cell, tpl_proc_it.second), tpl_proc_it.second);
 			map_attributes(cell, new_proc, tpl_proc_it.second->name);
 			for (auto new_proc_sync : new_proc->syncs)
 				for (auto &memwr_action : new_proc_sync->mem_write_actions)
 					memwr_action.memid = memory_map.at(memwr_action.memid).str();
-			auto rewriter = [&](RTLIL::SigSpec &sig) { map_sigspec(wire_map, sig); };
 			new_proc->rewrite_sigspecs(rewriter);
 			design->select(module, new_proc);
 		}
 
-		for (auto tpl_cell : tpl->cells()) {
-			RTLIL::Cell *new_cell = module->addCell(map_name(cell, tpl_cell), tpl_cell);
+		for (auto &tpl_cell_it : tpl_info.cells) {
+			RTLIL::Cell *tpl_cell = tpl_cell_it.first;
+			IdString new_name = concat_name(cell, tpl_cell_it.second.is_public, tpl_cell_it.second.suffix);
+			RTLIL::Cell *new_cell = module->addCell(module->uniquify(new_name), tpl_cell);
 			map_attributes(cell, new_cell, tpl_cell->name);
 			if (new_cell->has_memid()) {
 				IdString memid = new_cell->getParam(ID::MEMID).decode_string();
@@ -170,7 +261,6 @@ struct FlattenWorker
 				IdString memid = new_cell->getParam(ID::MEMID).decode_string();
 				new_cell->setParam(ID::MEMID, Const(concat_name(cell, memid).str()));
 			}
-			auto rewriter = [&](RTLIL::SigSpec &sig) { map_sigspec(wire_map, sig); };
 			new_cell->rewrite_sigspecs(rewriter);
 			design->select(module, new_cell);
 			new_cells.push_back(new_cell);
@@ -185,32 +275,20 @@ struct FlattenWorker
 
 		// Attach port connections of the flattened cell
 
-		pool<SigBit> tpl_driven;
-		for (auto tpl_cell : tpl->cells())
-			for (auto &tpl_conn : tpl_cell->connections())
-				if (tpl_cell->output(tpl_conn.first))
-					for (auto bit : tpl_conn.second)
-						tpl_driven.insert(bit);
-		for (auto &tpl_conn : tpl->connections())
-			for (auto bit : tpl_conn.first)
-				tpl_driven.insert(bit);
-
 		for (auto &port_it : cell->connections())
 		{
-			IdString port_name = port_it.first;
-			if (positional_ports.count(port_name) > 0)
-				port_name = positional_ports.at(port_name);
-			if (tpl->wire(port_name) == nullptr || tpl->wire(port_name)->port_id == 0) {
-				if (port_name.begins_with("$"))
+			auto tpl_port_it = tpl_info.ports.find(port_it.first);
+			if (tpl_port_it == tpl_info.ports.end()) {
+				if (port_it.first.begins_with("$"))
 					log_error("Can't map port `%s' of cell `%s' to template `%s'!\n",
-						port_name.c_str(), cell->name.c_str(), tpl->name.c_str());
+						port_it.first.c_str(), cell->name.c_str(), tpl->name.c_str());
 				continue;
 			}
 
 			if (GetSize(port_it.second) == 0)
 				continue;
 
-			RTLIL::Wire *tpl_wire = tpl->wire(port_name);
+			RTLIL::Wire *tpl_wire = tpl_port_it->second;
 			RTLIL::SigSig new_conn;
 			bool is_signed = false;
 			if (tpl_wire->port_output && !tpl_wire->port_input) {
@@ -224,7 +302,7 @@ struct FlattenWorker
 			} else {
 				SigSpec sig_tpl = tpl_wire, sig_mod = port_it.second;
 				for (int i = 0; i < GetSize(sig_tpl) && i < GetSize(sig_mod); i++) {
-					if (tpl_driven.count(sig_tpl[i])) {
+					if (tpl_info.driven.count(sig_tpl[i])) {
 						new_conn.first.append(sig_mod[i]);
 						new_conn.second.append(sig_tpl[i]);
 					} else {
@@ -284,6 +362,10 @@ struct FlattenWorker
 		if (!design->selected(module) || module->get_blackbox_attribute(ignore_wb))
 			return;
 
+		// This module is about to change, drop anything precomputed while
+		// it was used as a template.
+		invalidate_template(module);
+
 		SigMap sigmap(module);
 		std::vector<RTLIL::Cell*> worklist = module->selected_cells();
 		while (!worklist.empty())